@@ -1,460 +1,4893 @@
 /*
  Detective Quest - Sistema de pistas (versão melhorada)
  - Navegação com voltar (back), esquerda/direita, sair
- - Pistas coletadas armazenadas em BST com contador (conta duplicatas)
- - Tabela hash associa pista -> suspeito
- - Ao final, resumo completo e veredito (>=2 pistas para acusação válida)
+ - Pistas coletadas armazenadas em BST balanceada (AVL) com contador (conta duplicatas)
+ - Tabela hash (endereçamento aberto, Robin Hood, redimensionável) associa pista -> suspeitos:
+   um id na própria entrada, ou lista ordenada em varint de diferenças; o comando i
+   intersecta as listas das pistas coletadas
+ - Nós da BST alocados em arena e salas num vetor plano (liberação em bloco, sem percursos recursivos)
+ - Textos (nomes de salas, pistas, suspeitos) internados num pool único; os nós
+   guardam deslocamentos de 32 bits, então cada texto é armazenado uma só vez
+ - Suspeitos internados com ids inteiros; contagem de pistas por suspeito é
+   atualizada a cada coleta, então o veredito é O(1)
+ - Mapa em vetor plano de salas (filhos por índice); pode ser carregado de um
+   arquivo binário via mmap e navegado sem alocação por sala
+ - Passagens extras (laços, mais de duas saídas) formam um grafo em lista de
+   adjacência compacta; busca em largura dá a rota mais curta até a pista pendente mais próxima
+ - Ao final, resumo completo, probabilidade de cada suspeito pelas evidências
+   ponderadas (matriz esparsa pista x suspeito) e veredito (peso >= 2 contra o acusado)
  
- Compilar:
-    gcc -std=c11 -O2 -Wall detective_pistas_v2.c -o detective_pistas_v2
+ Compilar (POSIX):
+    gcc -std=c11 -O2 -Wall -pthread detectiveQuestMestre.c -o detective
+
+ Uso:
+    ./detective                              mapa padrão embutido
+    ./detective --mapa mansao.dqm            carrega mapa binário
+    ./detective --converter mansao.txt mansao.dqm
+                                             gera o binário a partir da descrição em texto
+                                             (formato em mansao_exemplo.txt)
+    ./detective --caso pistas.csv [--linhas N]
+                                             acrescenta associações pista;suspeito[;peso] de um
+                                             arquivo de caso (N = estimativa de linhas); uma
+                                             pista pode apontar para vários suspeitos
+    ./detective --sessao jogo.dqs            retoma a sessão gravada em jogo.dqs (se existir);
+                                             o comando g grava pistas, suspeitos e posição nele
+    ./detective --silencioso < comandos.txt  joga sem imprimir telas nem relatórios
+    ./detective --gerar N [--forma F] [--densidade D] [--repetidas R] [--suspeitos K]
+                [--semente S] [--threads T] [--gravar-mapa saida.dqm]
+                                             gera uma mansão de N salas (reprodutível pela
+                                             semente; forma balanceada, esquerda, direita ou
+                                             aleatoria) para jogar, --lote, --simular ou gravar
+    ./detective --lote sessoes.txt           modo em lote: cada linha é uma sessão com
+                                             comandos e/d/p/b/f/c/s, jN e vN ('-' = entrada padrão);
+                                             imprime só um registro por sessão
+    ./detective --simular N [--passos P] [--threads T] [--semente S]
+                                             N investigações aleatórias em paralelo sobre o
+                                             mesmo mapa/hash (somente leitura); cada thread
+                                             tem sua própria BST e contadores
+
+ Saída do jogo montada em buffer e gravada uma vez por tela/relatório;
+ --silencioso descarta telas e relatórios (útil em sessões roteirizadas).
+
+ Instrumentação (opcional, custo zero quando desligada):
+    gcc -std=c11 -O2 -Wall -pthread -DDQ_ESTATISTICAS detectiveQuestMestre.c -o detective
+    Ao sair, grava em JSON sondagens da hash, profundidade da BST, alocações por
+    estrutura e tempo de exploração/veredito; destino em DQ_ESTATISTICAS_SAIDA
+    (caminho de arquivo) ou saída de erro.
 */
 
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L /* mmap, fstat */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <locale.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <pthread.h>
 
-#define MAX_NAME 64
-#define HASH_SIZE 53    /* número primo para buckets */
-#define STACK_MAX 128   /* profundidade máxima para "voltar" */
+#define MAX_NAME 64     /* tamanho do buffer de leitura do nome do acusado */
+#define DESTAQUE_TOP 3  /* suspeitos mostrados no placar a cada sala */
+#define EVIDENCIA_MINIMA 2.0    /* peso acumulado contra o acusado para a acusação ser válida */
+#define EVIDENCIA_TOP 5         /* suspeitos listados com probabilidade no veredito */
+#define HASH_SIZE 64    /* capacidade inicial da hash (potência de 2) */
+#define HASH_CARGA_MAX 0.85 /* fator de carga que dispara o redimensionamento */
+#define HASH_HIST_MAX 16  /* faixas do histograma de sondagens (última acumula o resto) */
+#define HISTORICO_INICIAL 32  /* capacidade inicial das pilhas de voltar/avançar (dobra ao encher) */
+#define BST_ALTURA_MAX 64  /* pilha dos percursos da BST: uma AVL com 2^32 nós tem altura < 47 */
+#define SALA_NENHUMA UINT32_MAX  /* índice de filho ausente */
+#define MANSAO_MAGICA "DQMS"     /* assinatura do arquivo binário de mansão */
+#define MANSAO_VERSAO 5u          /* 2: passagens; 3: pistas com vários suspeitos; 4: pais e nomes; 5: grafo */
+#define SESSAO_MAGICA "DQSS"     /* assinatura do arquivo de sessão (investigação suspensa) */
+#define SESSAO_VERSAO 2u          /* 2: pistas com vários suspeitos */
+#define LINHA_MAX 4096          /* linha mais longa aceita no formato texto */
+#define CSV_BUFFER (1 << 20)    /* bloco lido por vez do arquivo de caso */
+#define ARENA_ALINHAMENTO 8                  /* suficiente para ponteiros e inteiros */
+#define ARENA_BLOCO_MIN (64 * 1024)          /* primeiro bloco de uma arena */
+#define ARENA_BLOCO_MAX (64 * 1024 * 1024)   /* teto do crescimento geométrico dos blocos */
+#define SAIDA_INICIAL 4096       /* buffer de saída inicial */
+#define SAIDA_LIMITE (64 * 1024) /* acima disto o buffer é gravado mesmo no meio de um relatório */
+#define SIM_PASSOS_PADRAO 32    /* movimentos por investigação simulada */
+#define SIM_THREADS_MAX 256
+#define GER_DENSIDADE_PADRAO 0.75   /* fração de salas geradas com pista */
+#define GER_REPETIDAS_PADRAO 0.05   /* fração das pistas que repetem a de outra sala */
+#define GER_SUSPEITOS_PADRAO 16
+#define GER_TENTATIVAS 8            /* sorteios de sala de origem para uma pista repetida */
+#define GER_TAREFAS_POR_THREAD 8    /* subárvores por thread na forma aleatória */
+#define LOTE_PARALELO_MIN (1 << 16) /* pistas por thread para ordenar um lote em paralelo */
 
 /* ----------------------- Estruturas ----------------------- */
 
-/* Nó da árvore de salas (mapa da mansão) */
+/* Bloco de uma arena: cabeçalho seguido da área de alocação */
+typedef struct BlocoArena {
+    struct BlocoArena *ant;     /* bloco alocado antes deste */
+    size_t tamanho;
+    size_t usado;
+    _Alignas(16) unsigned char dados[];
+} BlocoArena;
+
+/* Arena (alocador por incremento): objetos com o mesmo tempo de vida são
+   alocados em poucos blocos grandes e liberados todos de uma vez */
+typedef struct {
+    BlocoArena *atual;
+    size_t proximoBloco;        /* tamanho do próximo bloco (dobra até ARENA_BLOCO_MAX) */
+    size_t blocos;              /* blocos obtidos do malloc */
+} Arena;
+
+/* Referência a um texto internado: deslocamento em PoolStrings.dados; 0 = "" (sem texto) */
+typedef uint32_t StrId;
+
+/* Pool de strings internadas: cada texto distinto é guardado uma única vez,
+   concatenado com '\0' no fim; o índice (endereçamento aberto) mapeia texto -> StrId.
+   Um pool carregado de arquivo aponta para a região mapeada (cap = 0) e só
+   ganha cópia própria e índice quando precisa (primeira busca/internação). */
+typedef struct {
+    char *dados;                /* dados[0] = '\0' é a string vazia */
+    size_t usado;
+    size_t cap;                 /* 0 = dados não pertencem ao pool (mapeados) */
+    StrId *indice;              /* 0 = slot vazio */
+    size_t capIndice;           /* potência de 2 */
+    size_t qtd;                 /* strings distintas (fora a vazia) */
+} PoolStrings;
+
+/* Nó da árvore de salas (mapa da mansão); mesmo layout do arquivo binário */
 typedef struct Sala {
-    char nome[MAX_NAME];
-    char pista[MAX_NAME]; /* string vazia "" -> sem pista */
-    struct Sala *esquerda;
-    struct Sala *direita;
+    StrId nome;
+    StrId pista;                /* 0 -> sem pista */
+    uint32_t esquerda;          /* índice em Mansao.salas; SALA_NENHUMA = sem caminho */
+    uint32_t direita;
 } Sala;
 
-/* Nó da BST que armazena pistas coletadas; inclui contador para duplicatas */
+/* Tabela de símbolos: cada texto internado recebe um id denso (0, 1, 2...);
+   usada para os suspeitos da hash e para os nomes de salas (índice da mansão) */
+typedef struct {
+    StrId *nomes;               /* nomes[id], texto no pool */
+    size_t qtd;
+    size_t capNomes;
+    int *indice;                /* endereçamento aberto por StrId: id+1 por slot; 0 = vazio */
+    size_t capIndice;           /* potência de 2 */
+} TabelaSimbolos;
+
+/* Passagem extra entre duas salas (sem sentido); mesmo layout do arquivo binário.
+   Permite laços e mais de duas saídas além da árvore esquerda/direita. */
+typedef struct {
+    uint32_t a;
+    uint32_t b;
+} Passagem;
+
+/* Mapa da mansão: vetor plano de salas; salas[0] é o Hall (raiz da árvore).
+   esquerda/direita são a visão de compatibilidade (comandos e/d); o grafo
+   completo (árvore nos dois sentidos + passagens) fica em lista de adjacência
+   compacta (CSR). Índice e grafo são montados por indexarMansao() depois que
+   o mapa está completo; num arquivo v5, pais, ordem dos nomes e grafo vêm mapeados. */
+typedef struct {
+    Sala *salas;
+    uint32_t qtd;
+    uint32_t cap;               /* 0 = salas mapeadas de arquivo (somente leitura) */
+    PoolStrings *strings;
+    void *mapa;                 /* região mmap do arquivo, se carregada de disco */
+    size_t tamMapa;
+    TabelaSimbolos nomes;       /* nome da sala -> id denso */
+    uint32_t *salaDoNome;       /* [id do nome] = primeira sala com esse nome */
+    uint32_t *pai;              /* [sala] = sala com caminho até ela; SALA_NENHUMA = Hall/isolada */
+    uint32_t *ordemNomes;       /* arquivo v5: salas em ordem de nome (busca binária, sem 'nomes') */
+    int indiceMapeado;          /* pai, ordemNomes e grafo apontam para o arquivo (não são liberados) */
+    Passagem *passagens;
+    uint32_t qtdPassagens;
+    uint32_t capPassagens;      /* 0 = passagens mapeadas de arquivo */
+    uint32_t *inicioVizinhos;   /* vizinhos de s: vizinhos[inicioVizinhos[s] .. inicioVizinhos[s+1]) */
+    uint32_t *vizinhos;
+} Mansao;
+
+/* Nó da BST (balanceada como AVL) que armazena pistas coletadas; inclui contador para duplicatas */
 typedef struct BSTNode {
-    char pista[MAX_NAME];
+    StrId pista;
     int contador;               /* quantas vezes a pista foi coletada */
+    int altura;                 /* altura da subárvore (folha = 1), usada no balanceamento */
+    int suspeito;               /* id do suspeito apontado (cache da hash); -1 = nenhum */
     struct BSTNode *esq;
     struct BSTNode *dir;
 } BSTNode;
 
-/* Entrada na tabela hash (encadeamento) */
+/* Entrada na tabela hash (endereçamento aberto: as entradas ficam no próprio vetor).
+   Uma pista pode apontar para vários suspeitos: com um só, o id fica na
+   própria entrada; com mais, 'suspeito' = -(deslocamento + 1) da lista em
+   HashTable.listas. O suspeito principal é o da associação mais recente. */
 typedef struct HashEntry {
-    char pista[MAX_NAME];       /* chave */
-    char suspeito[MAX_NAME];    /* valor */
-    struct HashEntry *prox;
+    StrId pista;                /* chave (texto no pool) */
+    int suspeito;               /* valor: id na tabela de suspeitos (>= 0) ou lista (< 0) */
+    unsigned int hash;          /* hash completo da chave (filtra strcmp e evita recalcular) */
+    unsigned int dist;          /* distância até o slot ideal + 1; 0 = slot vazio */
 } HashEntry;
 
-/* Tabela hash */
+/* Tabela hash Robin Hood: um único bloco de slots, capacidade sempre potência de 2 */
 typedef struct {
-    HashEntry *buckets[HASH_SIZE];
+    HashEntry *slots;
+    size_t capacidade;
+    size_t qtd;
+    PoolStrings *strings;       /* pool compartilhado com o mapa (não pertence à hash) */
+    TabelaSimbolos suspeitos;  /* nomes internados em inserirNaHash */
+    /* listas de 2+ suspeitos: varint(principal) varint(qtd) e os ids em ordem
+       crescente como varint das diferenças; uma lista que cresce é regravada
+       no fim e o espaço antigo conta como lixo até a próxima compactação */
+    unsigned char *listas;
+    size_t usadoListas, capListas, lixoListas;
+    size_t qtdExtras;           /* associações além da principal, somadas */
 } HashTable;
 
+/* Suspeitos distintos presentes na hash e quantas pistas apontam para cada um */
+typedef struct {
+    int *ids;                   /* ids distintos, na ordem de internação */
+    size_t qtd;
+    size_t *pistas;             /* [id] = pistas da hash associadas ao suspeito */
+    int maisCitado;             /* id com mais pistas; -1 se a hash está vazia */
+} ResumoSuspeitos;
+
+/* Estado de uma investigação (por jogador): pistas coletadas e, para cada
+   suspeito, quantas delas apontam para ele (atualizado a cada coleta).
+   'ranking' mantém os suspeitos já citados em ordem decrescente de coletas;
+   os primeiros k são o top-k. Empates: ranking[0] é sempre o primeiro a
+   atingir a maior contagem; entre os demais a ordem não é definida (depende
+   das trocas feitas até ali), então quem exibe o ranking não a promete. */
+typedef struct {
+    Arena arena;                /* nós da BST */
+    BSTNode *raizPistas;
+    int *pistasPorSuspeito;     /* [id do suspeito] */
+    int *ranking;               /* ids com ao menos uma coleta, do mais citado ao menos */
+    int *posRanking;            /* [id] = posição em ranking (válida se pistasPorSuspeito[id] > 0) */
+    size_t qtdRanking;
+    size_t capSuspeitos;
+    size_t pistasDistintas;     /* nós da BST */
+    int maisCitado;             /* ranking[0] (primeiro a atingir a maior contagem); -1 = nenhum */
+} Investigacao;
+
+/* Pista de um lote importado de uma vez (coletarPistasEmLote) */
+typedef struct {
+    StrId pista;
+    int contador;               /* coletas a somar (<= 0: entrada ignorada) */
+} PistaLote;
+
+/* Evidências ponderadas, muitos-para-muitos: matriz esparsa pista x suspeito
+   em CSR. Cada pista tem uma linha densa; as entradas de uma linha (id do
+   suspeito e peso) ficam contíguas, em vetores separados. Os ids de suspeito
+   são os da tabela da hash. Montada uma vez (triplas acumuladas, depois
+   ordenação por contagem); só lida durante a pontuação. */
+typedef struct {
+    TabelaSimbolos pistas;      /* StrId da pista -> linha */
+    uint32_t *inicio;           /* linha l: entradas [inicio[l], inicio[l+1]) */
+    int *suspeito;
+    float *peso;
+    size_t qtdLinhas;           /* pistas com linha montada */
+    size_t qtdEntradas;
+    size_t qtdSuspeitos;        /* colunas (suspeitos da hash na montagem) */
+    /* triplas pendentes, antes de montarEvidencias */
+    uint32_t *linhaT;
+    int *suspeitoT;
+    float *pesoT;
+    size_t qtdT, capT;
+} MatrizEvidencias;
+
+/* Pontuação dos suspeitos para as pistas coletadas (vetores reaproveitados) */
+typedef struct {
+    double *pontos;             /* [id] = soma de peso x coletas; 0 fora do ranking */
+    int *ranking;               /* ids com pontos > 0, do maior para o menor */
+    size_t qtdRanking;
+    size_t cap;
+    double total;               /* soma dos pontos: probabilidade = pontos / total */
+} PontuacaoSuspeitos;
+
+/* Índice de trigramas para busca por trecho: cada sequência de 3 bytes aponta
+   para a lista (CSR) dos textos que a contêm. Uma consulta verifica só os
+   textos da lista mais curta entre os trigramas do trecho. Textos acrescentados
+   depois da montagem ficam, por trigrama, numa lista ligada após a parte CSR. */
+typedef struct {
+    StrId *textos;              /* textos indexados, na ordem recebida */
+    size_t qtd, capTextos;
+    uint32_t *chaves;           /* tabela aberta: trigrama + 1; 0 = slot vazio */
+    uint32_t *ids;              /* [slot] = id denso do trigrama */
+    size_t capTabela;           /* potência de 2 */
+    size_t qtdTrigramas;
+    size_t trigramasCSR;        /* ids abaixo disso têm lista no CSR */
+    uint32_t *inicio;           /* textos com o trigrama t: ocorrencias[inicio[t] .. inicio[t+1]) */
+    uint32_t *ocorrencias;      /* índices em 'textos' */
+    /* acrescentados: por id, primeira e última entrada (+1; 0 = nenhuma) e quantas */
+    uint32_t *extraPrimeiro, *extraUltimo, *extraQtd;
+    size_t capExtraIds;
+    uint32_t *extraTexto;       /* [entrada] = índice em 'textos' */
+    uint32_t *extraProximo;     /* [entrada] = próxima do mesmo trigrama + 1; 0 = fim */
+    size_t qtdExtras, capExtras;
+} IndiceTrigramas;
+
+/* Posição do jogador e histórico: pilha para 'voltar' e pilha para 'avançar'
+   (refazer). Ciclos são compactados: ao entrar numa sala que já está na pilha,
+   o trecho depois dela é descartado, então pilha + atual + frente nunca repetem
+   sala e o histórico fica limitado ao nº de salas, qualquer que seja a sessão. */
+typedef struct {
+    uint32_t atual;
+    uint32_t *pilha;            /* salas anteriores; pilha[topo-1] é a mais recente */
+    size_t topo, capPilha;
+    uint32_t *frente;           /* salas desfeitas por 'voltar'; frente[qtdFrente-1] é a próxima */
+    size_t qtdFrente, capFrente;
+    uint32_t *posicao;          /* [sala] = índice + 1 na pilha; 0 = fora da pilha */
+    uint32_t qtdSalas;
+} Navegacao;
+
+/* Busca em largura sobre o grafo da mansão. Os vetores têm uma entrada por
+   sala e são reaproveitados entre buscas: 'marca' guarda a geração da última
+   busca que alcançou a sala, então não é preciso zerar nada a cada consulta. */
+typedef struct {
+    uint32_t *fila;
+    uint32_t *anterior;         /* [sala] = sala de onde a busca chegou */
+    uint32_t *marca;            /* [sala] = geração que a visitou */
+    uint32_t *rota;             /* rota[0..passos]: origem ... destino da última busca */
+    uint32_t geracao;
+    uint32_t qtdSalas;
+} PlanejadorRota;
+
+/* Resultado de um comando de movimento */
+typedef enum {
+    MOV_OK,
+    MOV_SEM_CAMINHO,            /* não há sala na direção pedida */
+    MOV_SEM_ANTERIOR,           /* 'voltar' com pilha vazia */
+    MOV_SEM_PROXIMA,            /* 'avançar' sem nada a refazer */
+    MOV_SAIR,
+    MOV_INVALIDO
+} ResultadoMovimento;
+
+/* Como a saída do jogo chega ao terminal */
+typedef enum {
+    SAIDA_BUFFER,               /* monta a tela/relatório e grava de uma vez */
+    SAIDA_DIRETA,               /* um fprintf por linha (comportamento antigo) */
+    SAIDA_SILENCIOSA            /* descarta tudo */
+} ModoSaida;
+
+/* Buffer reaproveitável para telas e relatórios */
+typedef struct {
+    char *dados;
+    size_t usado, cap;
+    FILE *destino;
+    ModoSaida modo;
+} Saida;
+
+/* Parâmetros da simulação em massa */
+typedef struct {
+    size_t sessoes;
+    unsigned passos;            /* movimentos por sessão */
+    unsigned threads;
+    uint64_t semente;           /* sessão i usa sempre o mesmo gerador, qualquer que seja o nº de threads */
+} ParametrosSimulacao;
+
+/* Totais da simulação (somados por thread e agregados no fim) */
+typedef struct {
+    size_t sessoes;
+    size_t validas;             /* acusação do de maior peso, com peso >= EVIDENCIA_MINIMA */
+    size_t fracas;              /* maior peso abaixo de EVIDENCIA_MINIMA */
+    size_t semSuspeito;         /* nenhuma pista com evidência contra suspeito */
+    size_t passos;
+    size_t pistas;              /* pistas distintas coletadas, somadas */
+    size_t *votos;              /* [id do suspeito] = acusações válidas */
+    size_t qtdSuspeitos;
+    double segundos;
+} ResultadoSimulacao;
+
+/* Arquivo binário de mansão (inteiros na ordem de bytes da máquina):
+   cabeçalho | Sala[qtdSalas] | Passagem[qtdPassagens] | pai[qtdSalas] | ordemNomes[qtdSalas]
+   | inicioVizinhos[qtdSalas + 1] | vizinhos[qtdArestas] | AssocArquivo[qtdAssoc + qtdAssocExtras]
+   | strings[tamStrings]
+   Os StrId das salas e associações são deslocamentos na tabela de strings.
+   As qtdAssoc primeiras associações dão o suspeito principal de cada pista; as
+   extras completam as listas. pai, ordemNomes (salas por nome, empates pelo
+   índice) e o grafo em CSR são usados direto do mapeamento. Arquivos da versão
+   1 terminam o cabeçalho em offStrings e não têm passagens; os da versão 2 não
+   têm extras; os das versões 2 a 4 terminam em offPassagens e são indexados na
+   carga (a versão 4 não tinha o grafo e seus pais/nomes são ignorados). */
+typedef struct {
+    char magica[4];             /* MANSAO_MAGICA */
+    uint32_t versao;            /* MANSAO_VERSAO */
+    uint32_t qtdSalas;
+    uint32_t qtdAssoc;
+    uint64_t tamStrings;
+    uint64_t offSalas;
+    uint64_t offAssoc;
+    uint64_t offStrings;
+    uint32_t qtdPassagens;      /* versão >= 2 */
+    uint32_t qtdAssocExtras;    /* versão >= 3 */
+    uint64_t offPassagens;
+    uint64_t offIndice;         /* versão >= 5: pai, ordemNomes, inicioVizinhos e vizinhos */
+    uint32_t qtdArestas;        /* versão >= 5: entradas em vizinhos */
+    uint32_t reservado;
+} CabecalhoMansao;
+
+/* Associação pista -> suspeito no arquivo */
+typedef struct {
+    StrId pista;
+    StrId suspeito;
+} AssocArquivo;
+
+/* Arquivo de sessão (inteiros na ordem de bytes da máquina):
+   cabeçalho | pilha[topo] | frente[qtdFrente] | PistaSessao[qtdPistas] (em ordem)
+   | AssocArquivo[qtdAssoc] | AssocArquivo[qtdExtras] | suspeitos[qtdSuspeitos] (StrId por id)
+   | ranking[qtdRanking]
+   | contagens[qtdRanking] | strings[tamStrings]
+   'soma' cobre tudo depois do cabeçalho; 'somaMapa' cobre salas e passagens do
+   mapa em uso, cujos StrId têm de valer também no pool gravado. */
+typedef struct {
+    char magica[4];             /* SESSAO_MAGICA */
+    uint32_t versao;            /* SESSAO_VERSAO */
+    uint64_t soma;
+    uint64_t somaMapa;
+    uint32_t qtdSalas;
+    uint32_t atual;
+    uint64_t topo;
+    uint64_t qtdFrente;
+    uint64_t qtdPistas;
+    uint64_t qtdAssoc;
+    uint64_t qtdExtras;         /* associações além da principal de cada pista */
+    uint64_t qtdSuspeitos;
+    uint64_t qtdRanking;
+    uint64_t tamStrings;
+} CabecalhoSessao;
+
+/* Pista coletada no arquivo de sessão (a altura é recalculada na carga) */
+typedef struct {
+    StrId pista;
+    int32_t contador;
+    int32_t suspeito;
+} PistaSessao;
+
+/* Resultado da carga de um arquivo de caso */
+typedef struct {
+    size_t linhas;              /* associações inseridas */
+    size_t ignoradas;           /* linhas vazias, cabeçalho ou sem os dois campos */
+    double segundos;
+    long picoMemoriaKB;         /* pico de memória residente do processo */
+} RelatorioCarga;
+
+/* Formato da árvore gerada */
+typedef enum {
+    FORMA_BALANCEADA,           /* filhos de i em 2i+1 e 2i+2 */
+    FORMA_CADEIA_ESQUERDA,      /* i -> i+1 sempre à esquerda (altura = salas) */
+    FORMA_CADEIA_DIREITA,
+    FORMA_ALEATORIA             /* divisões aleatórias da faixa de salas (forma de BST aleatória) */
+} FormaMansao;
+
+/* Parâmetros do gerador de mansões. Cada sala é decidida só por (semente,
+   índice): o mesmo mapa sai com qualquer número de threads. */
+typedef struct {
+    uint32_t salas;
+    FormaMansao forma;
+    double densidade;           /* probabilidade de uma sala ter pista */
+    double repetidas;           /* probabilidade de a pista repetir a de uma sala anterior */
+    uint32_t suspeitos;         /* cada pista distinta aponta para um deles */
+    uint64_t semente;
+    unsigned threads;           /* 0 = um por núcleo */
+} ParametrosGerador;
+
+/* Resultado da geração */
+typedef struct {
+    size_t pistas;              /* pistas distintas (= associações na hash) */
+    size_t repetidas;           /* salas cuja pista já aparece em outra */
+    size_t bytesTexto;
+    double segundos;            /* salas, textos e hash; sem indexarMansao */
+} RelatorioGerador;
+
+/* Estatísticas de ocupação e de comprimento de sondagem da hash */
+typedef struct {
+    size_t capacidade;
+    size_t qtd;
+    double fatorCarga;
+    double sondagemMedia;       /* slots visitados, em média, para achar uma chave presente */
+    unsigned int sondagemMax;
+    size_t histograma[HASH_HIST_MAX]; /* [k] = chaves achadas com k+1 sondagens */
+} EstatisticasHash;
+
+/* Contadores de instrumentação (compilados só com -DDQ_ESTATISTICAS).
+   Cada thread incrementa sua cópia local; as cópias são somadas no fim. */
+#ifdef DQ_ESTATISTICAS
+typedef enum {
+    EST_ARENA,                  /* blocos da arena (nós da BST) */
+    EST_POOL,                   /* textos e índice do pool */
+    EST_MANSAO,                 /* vetor de salas */
+    EST_HASH,                   /* slots da hash */
+    EST_SIMBOLOS,               /* tabela de suspeitos */
+    EST_INVESTIGACAO,           /* contadores por suspeito */
+    EST_RESUMO,                 /* listas de suspeitos distintos */
+    EST_EVIDENCIAS,             /* matriz de evidências ponderadas e pontuação */
+    EST_QTD
+} EstruturaEstat;
+
+typedef struct {
+    uint64_t buscasHash;
+    uint64_t sondagensHash;     /* slots visitados, somados */
+    uint64_t histSondagem[HASH_HIST_MAX]; /* [k] = buscas com k+1 sondagens */
+    uint64_t insercoesBST;
+    uint64_t nosInsercao;       /* nós visitados pelas inserções, somados */
+    uint64_t buscasBST;
+    uint64_t nosBusca;
+    uint64_t alturaMaxBST;
+    uint64_t alocacoes[EST_QTD];
+    uint64_t bytes[EST_QTD];
+    uint64_t nsExplorar;
+    uint64_t nsVeredito;
+} EstatisticasMotor;
+
+void despejarEstatisticas(void);    /* JSON em DQ_ESTATISTICAS_SAIDA ou stderr */
+uint64_t relogioNs(void);
+
+#define ESTAT(x) (x)
+#define ESTAT_ALOC(estrutura, tam) (estatLocal.alocacoes[estrutura]++, estatLocal.bytes[estrutura] += (tam))
+#else
+#define ESTAT(x) ((void) 0)
+#define ESTAT_ALOC(estrutura, tam) ((void) 0)
+#endif
+
 /* -------------------- Protótipos das funções -------------------- */
 
-/* criarSala() – cria dinamicamente uma sala */
-Sala* criarSala(const char *nome, const char *pista);
+/* arena: alocação por incremento e liberação em bloco */
+void inicializarArena(Arena *a);
+void* arenaAlocar(Arena *a, size_t tamanho);
+void arenaReiniciar(Arena *a);
+void liberarArena(Arena *a);
+
+/* pool de strings: internação e acesso ao texto */
+void inicializarPool(PoolStrings *ps);
+StrId internarString(PoolStrings *ps, const char *texto);
+StrId buscarString(PoolStrings *ps, const char *texto); /* 0 se não internado */
+void reservarPool(PoolStrings *ps, size_t bytes, size_t qtdStrings);
+void liberarPool(PoolStrings *ps);
+
+/* mansão: vetor de salas, criarSala() devolve o índice da nova sala */
+void inicializarMansao(Mansao *m, PoolStrings *ps);
+uint32_t criarSala(Mansao *m, const char *nome, const char *pista);
+void conectarSalas(Mansao *m, uint32_t sala, uint32_t esquerda, uint32_t direita);
+void conectarPassagem(Mansao *m, uint32_t a, uint32_t b);
+void indexarMansao(Mansao *m);
+uint32_t buscarSalaPorNome(const Mansao *m, const char *nome); /* SALA_NENHUMA se não existe */
+uint32_t salaPai(const Mansao *m, uint32_t sala);               /* SALA_NENHUMA para o Hall */
+void liberarMansao(Mansao *m);
 
-/* explorarSalas() – navega pela árvore e ativa o sistema de pistas */
-void explorarSalas(Sala *raiz, BSTNode **raizPistas, HashTable *ht);
+/* formato binário: gravação, carga com mmap e conversão do formato texto */
+int salvarMansaoBinaria(const Mansao *m, const HashTable *ht, const char *caminho);
+int carregarMansaoBinaria(const char *caminho, Mansao *m, PoolStrings *ps, HashTable *ht);
+int carregarMansaoTexto(const char *caminho, Mansao *m, HashTable *ht);
+int converterMansaoTexto(const char *entrada, const char *saida);
+
+/* sessão: grava/retoma posição, histórico, pistas coletadas, contagens e hash */
+int salvarSessao(const char *caminho, const Mansao *m, const HashTable *ht,
+                 const Investigacao *inv, const Navegacao *nav);
+int carregarSessao(const char *caminho, const Mansao *m, HashTable *ht,
+                   Investigacao *inv, Navegacao *nav);
+void montarMansaoPadrao(Mansao *m, HashTable *ht); /* mapa fixo do jogo */
+
+/* gerador: mansões grandes e reprodutíveis para testes de escala (mapa e hash vazios) */
+int gerarMansao(Mansao *m, HashTable *ht, const ParametrosGerador *p, RelatorioGerador *rel);
+
+/* arquivo de caso: associações pista/suspeito em massa (CSV com ';', ',' ou tab) */
+int carregarCasoCSV(HashTable *ht, const char *caminho, size_t dicaLinhas, RelatorioCarga *rel,
+                    MatrizEvidencias *ev); /* ev opcional: recebe as linhas com o peso (3ª coluna) */
+
+/* saída em buffer: telas e relatórios gravados de uma vez */
+void inicializarSaida(Saida *out, FILE *destino, ModoSaida modo);
+void saidaPrintf(Saida *out, const char *fmt, ...);
+void saidaDescarregar(Saida *out);
+void liberarSaida(Saida *out);
+
+/* navegação: movimento e coleta ao entrar numa sala (compartilhados por jogo e lote) */
+void iniciarNavegacao(Navegacao *nav, const Mansao *m);
+void reiniciarNavegacao(Navegacao *nav);
+ResultadoMovimento moverJogador(const Mansao *m, Navegacao *nav, char comando);
+ResultadoMovimento saltarHistorico(Navegacao *nav, size_t posicao);
+ResultadoMovimento irParaSala(const Mansao *m, Navegacao *nav, uint32_t sala);
+ResultadoMovimento passarPor(const Mansao *m, Navegacao *nav, size_t saida);
+void liberarNavegacao(Navegacao *nav);
+BSTNode* visitarSala(const Mansao *m, Investigacao *inv, const HashTable *ht, uint32_t sala, int *nova);
+
+/* planejador: caminho mais curto até a sala mais próxima com pista não coletada */
+void iniciarPlanejador(PlanejadorRota *pr, const Mansao *m);
+uint32_t planejarRotaPista(PlanejadorRota *pr, const Mansao *m, const Investigacao *inv,
+                           uint32_t origem, size_t *passos); /* SALA_NENHUMA se não há */
+void liberarPlanejador(PlanejadorRota *pr);
+
+/* explorarSalas() – navega pela árvore e ativa o sistema de pistas; 'g' grava a sessão em arqSessao */
+void explorarSalas(const Mansao *m, Investigacao *inv, HashTable *ht, Navegacao *nav,
+                   const char *arqSessao, Saida *out);
+
+/* executarLote() – repete sessões gravadas (uma por linha) sem menus */
+int executarLote(const Mansao *m, HashTable *ht, FILE *entrada, FILE *saida);
+
+/* simularInvestigacoes() – N sessões aleatórias em paralelo, mapa, hash e evidências compartilhados */
+int simularInvestigacoes(const Mansao *m, const HashTable *ht, const MatrizEvidencias *ev,
+                         const ParametrosSimulacao *p, ResultadoSimulacao *r);
+void liberarResultadoSimulacao(ResultadoSimulacao *r);
 
 /* inserirPista() / adicionarPista() – insere/atualiza a pista coletada na BST */
-BSTNode* inserirPista(BSTNode *raiz, const char *pista);
-BSTNode* buscarPistaNode(BSTNode *raiz, const char *pista); /* retorna ponteiro ou NULL */
+BSTNode* inserirPista(Arena *arena, const PoolStrings *ps, BSTNode *raiz, StrId pista, int suspeito,
+                      BSTNode **no); /* *no = nó criado ou incrementado (se 'no' != NULL) */
+BSTNode* buscarPistaNode(const PoolStrings *ps, BSTNode *raiz, const char *pista); /* retorna ponteiro ou NULL */
+
+/* busca de texto nas pistas: prefixo pela ordem da BST, trecho por trigramas.
+   Devolvem o total de resultados e gravam até 'max' deles em 'saida'. */
+size_t buscarPistasPorPrefixo(const PoolStrings *ps, const BSTNode *raiz, const char *prefixo,
+                              StrId *saida, size_t max);
+void indexarTrigramas(IndiceTrigramas *ix, const PoolStrings *ps, const StrId *textos, size_t qtd);
+void acrescentarTrigramas(IndiceTrigramas *ix, const PoolStrings *ps, StrId texto);
+size_t buscarPorTrecho(const IndiceTrigramas *ix, const PoolStrings *ps, const char *trecho,
+                       StrId *saida, size_t max);
+void liberarTrigramas(IndiceTrigramas *ix);
+
+/* tabela de símbolos: StrId <-> id denso */
+int internarSimbolo(TabelaSimbolos *ts, StrId nome);
+int buscarSimbolo(const TabelaSimbolos *ts, StrId nome); /* -1 se desconhecido */
+StrId simboloStr(const TabelaSimbolos *ts, int id);  /* 0 para id inválido */
+void liberarSimbolos(TabelaSimbolos *ts);
+const char* nomeSuspeito(const HashTable *ht, int id);      /* NULL para id inválido */
+
+/* investigação: coleta incremental e contagem O(1) por suspeito */
+void inicializarInvestigacao(Investigacao *inv);
+BSTNode* coletarPista(Investigacao *inv, const HashTable *ht, StrId pista);
+size_t coletarPistasEmLote(Investigacao *inv, const HashTable *ht, const PistaLote *lote, size_t qtd,
+                           unsigned threads); /* devolve quantas pistas novas */
+void reiniciarInvestigacao(Investigacao *inv);
+size_t suspeitosEmDestaque(const Investigacao *inv, size_t k, const int **ids); /* top-k, sem cópia */
+int contadorPistasParaSuspeito(const Investigacao *inv, const HashTable *ht, const char *suspeito);
+void liberarInvestigacao(Investigacao *inv);
 
 /* inserirNaHash() – insere associação pista/suspeito na tabela hash */
-void inicializarHash(HashTable *ht);
+void inicializarHash(HashTable *ht, PoolStrings *ps);
+void inicializarHashCapacidade(HashTable *ht, PoolStrings *ps, size_t capacidade);
+void reservarHash(HashTable *ht, size_t qtdEsperada);
 unsigned long hash_djb2(const char *str);
 void inserirNaHash(HashTable *ht, const char *pista, const char *suspeito);
+void inserirNaHashStr(HashTable *ht, StrId pista, StrId suspeito);
+void acrescentarSuspeitoStr(HashTable *ht, StrId pista, StrId suspeito); /* sem mudar o principal */
+size_t suspeitosDaPista(const HashTable *ht, StrId pista, int *ids, size_t max); /* total; ids em ordem */
+size_t intersectarSuspeitos(const HashTable *ht, const StrId *pistas, size_t qtd, int *saida, size_t *usadas);
 const char* encontrarSuspeito(HashTable *ht, const char *pista);
+int encontrarSuspeitoId(const HashTable *ht, const char *pista); /* -1 se sem associação */
+int encontrarSuspeitoIdStr(const HashTable *ht, StrId pista);
+void estatisticasHash(const HashTable *ht, EstatisticasHash *est);
+void imprimirEstatisticasHash(const HashTable *ht);
 
-/* verificarSuspeitoFinal() – fase de julgamento final */
-void verificarSuspeitoFinal(BSTNode *raizPistas, HashTable *ht);
+/* evidências ponderadas: triplas pista/suspeito/peso -> CSR; pontuação em uma passada */
+void inicializarEvidencias(MatrizEvidencias *ev);
+void adicionarEvidencia(MatrizEvidencias *ev, HashTable *ht, StrId pista, StrId suspeito, float peso);
+void montarEvidencias(MatrizEvidencias *ev, HashTable *ht);
+size_t pontuarSuspeitos(const MatrizEvidencias *ev, const Investigacao *inv, PontuacaoSuspeitos *pt);
+void liberarEvidencias(MatrizEvidencias *ev);
+void liberarPontuacao(PontuacaoSuspeitos *pt);
+
+/* verificarSuspeitoFinal() – fase de julgamento final (ev NULL = só contagens da hash) */
+void verificarSuspeitoFinal(Investigacao *inv, HashTable *ht, const MatrizEvidencias *ev, Saida *out);
 
 /* auxiliares: imprimir pistas (in-order), liberar estruturas, listar suspeitos */
-void imprimirPistasComContagem(BSTNode *raiz, HashTable *ht);
-void coletarSuspeitosUnicos(HashTable *ht, char nomes[][MAX_NAME], int *qtd);
-void imprimirSuspeitos(HashTable *ht);
-void liberarBST(BSTNode *raiz);
-void liberarArvore(Sala *raiz);
+void imprimirPistasComContagem(BSTNode *raiz, HashTable *ht, Saida *out);
+void coletarSuspeitosUnicos(const HashTable *ht, ResumoSuspeitos *r);
+void liberarResumoSuspeitos(ResumoSuspeitos *r);
+void imprimirSuspeitos(HashTable *ht, Saida *out);
 void liberarHash(HashTable *ht);
 
 /* -------------------- Implementações -------------------- */
 
-/* criarSala: aloca e inicializa dinamicamente uma sala com nome e pista */
-Sala* criarSala(const char *nome, const char *pista) {
-    Sala *s = (Sala*) malloc(sizeof(Sala));
-    if (!s) {
-        fprintf(stderr, "Erro: falha ao alocar memória para sala.\n");
-        exit(EXIT_FAILURE);
+#ifdef DQ_ESTATISTICAS
+static _Thread_local EstatisticasMotor estatLocal;
+static EstatisticasMotor estatTotal;
+static pthread_mutex_t estatTrava = PTHREAD_MUTEX_INITIALIZER;
+static const char *nomesEstruturas[EST_QTD] = {
+    "arena", "pool", "mansao", "hash", "simbolos", "investigacao", "resumo", "evidencias"
+};
+
+/* registrarSondagem: uma busca na hash que visitou 'd' slots */
+static inline void registrarSondagem(unsigned int d) {
+    estatLocal.buscasHash++;
+    estatLocal.sondagensHash += d;
+    estatLocal.histSondagem[d <= HASH_HIST_MAX ? d - 1 : HASH_HIST_MAX - 1]++;
+}
+
+/* fundirEstatisticas: soma os contadores da thread atual ao total e os zera */
+static void fundirEstatisticas(void) {
+    pthread_mutex_lock(&estatTrava);
+    uint64_t alturaMax = estatLocal.alturaMaxBST > estatTotal.alturaMaxBST ? estatLocal.alturaMaxBST
+                                                                          : estatTotal.alturaMaxBST;
+    uint64_t *dst = (uint64_t*) &estatTotal, *src = (uint64_t*) &estatLocal;
+    for (size_t k = 0; k < sizeof(EstatisticasMotor) / sizeof(uint64_t); ++k) dst[k] += src[k];
+    estatTotal.alturaMaxBST = alturaMax; /* máximo, não soma */
+    pthread_mutex_unlock(&estatTrava);
+    memset(&estatLocal, 0, sizeof estatLocal);
+}
+
+/* despejarEstatisticas: grava os contadores em JSON (registrada com atexit) */
+void despejarEstatisticas(void) {
+    fundirEstatisticas();
+    const EstatisticasMotor *e = &estatTotal;
+
+    const char *caminho = getenv("DQ_ESTATISTICAS_SAIDA");
+    FILE *f = caminho ? fopen(caminho, "w") : stderr;
+    if (!f) { perror(caminho); return; }
+    fprintf(f, "{\n  \"hash\": {\"buscas\": %llu, \"sondagens\": %llu, \"sondagemMedia\": %.3f, \"histograma\": [",
+            (unsigned long long) e->buscasHash, (unsigned long long) e->sondagensHash,
+            e->buscasHash ? (double) e->sondagensHash / e->buscasHash : 0.0);
+    for (int k = 0; k < HASH_HIST_MAX; ++k)
+        fprintf(f, "%s%llu", k ? ", " : "", (unsigned long long) e->histSondagem[k]);
+    fprintf(f, "]},\n  \"bst\": {\"insercoes\": %llu, \"profundidadeMediaInsercao\": %.3f, "
+               "\"buscas\": %llu, \"profundidadeMediaBusca\": %.3f, \"alturaMax\": %llu},\n",
+            (unsigned long long) e->insercoesBST,
+            e->insercoesBST ? (double) e->nosInsercao / e->insercoesBST : 0.0,
+            (unsigned long long) e->buscasBST,
+            e->buscasBST ? (double) e->nosBusca / e->buscasBST : 0.0,
+            (unsigned long long) e->alturaMaxBST);
+    fprintf(f, "  \"alocacoes\": {");
+    for (int k = 0; k < EST_QTD; ++k)
+        fprintf(f, "%s\"%s\": {\"chamadas\": %llu, \"bytes\": %llu}", k ? ", " : "", nomesEstruturas[k],
+                (unsigned long long) e->alocacoes[k], (unsigned long long) e->bytes[k]);
+    fprintf(f, "},\n  \"tempo\": {\"explorarSalasMs\": %.3f, \"verificarSuspeitoFinalMs\": %.3f}\n}\n",
+            e->nsExplorar / 1e6, e->nsVeredito / 1e6);
+    if (f != stderr) fclose(f);
+}
+
+/* relogioNs: relógio monotônico para os tempos por fase */
+uint64_t relogioNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+#endif
+
+/* inicializarArena: arena vazia; o primeiro bloco só é obtido na primeira alocação */
+void inicializarArena(Arena *a) {
+    a->atual = NULL;
+    a->proximoBloco = ARENA_BLOCO_MIN;
+    a->blocos = 0;
+}
+
+/* arenaAlocar: reserva 'tamanho' bytes alinhados a ARENA_ALINHAMENTO; abre bloco novo quando o atual enche */
+void* arenaAlocar(Arena *a, size_t tamanho) {
+    tamanho = (tamanho + ARENA_ALINHAMENTO - 1) & ~(size_t) (ARENA_ALINHAMENTO - 1);
+    BlocoArena *b = a->atual;
+    if (!b || b->tamanho - b->usado < tamanho) {
+        size_t cap = a->proximoBloco;
+        if (cap < tamanho) cap = tamanho;
+        b = (BlocoArena*) malloc(sizeof(BlocoArena) + cap);
+        ESTAT_ALOC(EST_ARENA, sizeof(BlocoArena) + cap);
+        if (!b) {
+            fprintf(stderr, "Erro: falha ao alocar bloco da arena.\n");
+            exit(EXIT_FAILURE);
+        }
+        b->ant = a->atual;
+        b->tamanho = cap;
+        b->usado = 0;
+        a->atual = b;
+        a->blocos++;
+        if (a->proximoBloco < ARENA_BLOCO_MAX) a->proximoBloco *= 2;
     }
-    strncpy(s->nome, nome, MAX_NAME-1);
-    s->nome[MAX_NAME-1] = '\0';
-    if (pista && pista[0] != '\0') {
-        strncpy(s->pista, pista, MAX_NAME-1);
-        s->pista[MAX_NAME-1] = '\0';
-    } else {
-        s->pista[0] = '\0';
-    }
-    s->esquerda = s->direita = NULL;
-    return s;
-}
-
-/* inserirPista: insere pista na BST; se existir, incrementa contador */
-BSTNode* inserirPista(BSTNode *raiz, const char *pista) {
-    if (!pista || pista[0] == '\0') return raiz;
-    if (raiz == NULL) {
-        BSTNode *n = (BSTNode*) malloc(sizeof(BSTNode));
-        if (!n) { fprintf(stderr, "Erro de memória BST\n"); exit(EXIT_FAILURE); }
-        strncpy(n->pista, pista, MAX_NAME-1);
-        n->pista[MAX_NAME-1] = '\0';
-        n->contador = 1;
-        n->esq = n->dir = NULL;
-        return n;
-    }
-    int cmp = strcmp(pista, raiz->pista);
-    if (cmp == 0) {
-        raiz->contador += 1; /* incrementa duplicata */
-    } else if (cmp < 0) {
-        raiz->esq = inserirPista(raiz->esq, pista);
-    } else {
-        raiz->dir = inserirPista(raiz->dir, pista);
+    void *p = b->dados + b->usado;
+    b->usado += tamanho;
+    return p;
+}
+
+/* arenaReiniciar: esvazia a arena mantendo só o bloco mais recente (o maior)
+   para reaproveitá-lo; os demais são devolvidos */
+void arenaReiniciar(Arena *a) {
+    BlocoArena *b = a->atual;
+    if (!b) return;
+    BlocoArena *ant = b->ant;
+    while (ant) {
+        BlocoArena *x = ant->ant;
+        free(ant);
+        ant = x;
     }
-    return raiz;
+    b->ant = NULL;
+    b->usado = 0;
+    a->blocos = 1;
 }
 
-/* buscarPistaNode: retorna nó se existir */
-BSTNode* buscarPistaNode(BSTNode *raiz, const char *pista) {
-    if (!raiz || !pista) return NULL;
-    int cmp = strcmp(pista, raiz->pista);
-    if (cmp == 0) return raiz;
-    if (cmp < 0) return buscarPistaNode(raiz->esq, pista);
-    return buscarPistaNode(raiz->dir, pista);
+/* liberarArena: devolve todos os blocos (um free por bloco, não por objeto) */
+void liberarArena(Arena *a) {
+    BlocoArena *b = a->atual;
+    while (b) {
+        BlocoArena *ant = b->ant;
+        free(b);
+        b = ant;
+    }
+    inicializarArena(a);
 }
 
-/* Inicializa a tabela hash (define buckets como NULL) */
-void inicializarHash(HashTable *ht) {
-    for (int i = 0; i < HASH_SIZE; ++i) ht->buckets[i] = NULL;
+/* arredonda para a próxima potência de 2 (mínimo 8) */
+static size_t potenciaDe2(size_t n) {
+    size_t p = 8;
+    while (p < n) p <<= 1;
+    return p;
 }
 
-/* djb2 hash */
+/* djb2 hash (valor completo; o índice do slot é obtido com a máscara da capacidade) */
 unsigned long hash_djb2(const char *str) {
     unsigned long hash = 5381;
     int c;
     while ((c = (unsigned char)*str++))
         hash = ((hash << 5) + hash) + c;
-    return hash % HASH_SIZE;
+    return hash;
 }
 
-/* inserirNaHash: insere par pista->suspeito (substitui se já existir) */
-void inserirNaHash(HashTable *ht, const char *pista, const char *suspeito) {
-    if (!pista || !suspeito) return;
-    unsigned long key = hash_djb2(pista);
-    HashEntry *cur = ht->buckets[key];
-    while (cur) {
-        if (strcmp(cur->pista, pista) == 0) {
-            strncpy(cur->suspeito, suspeito, MAX_NAME-1);
-            cur->suspeito[MAX_NAME-1] = '\0';
-            return;
-        }
-        cur = cur->prox;
+/* multiplicarDobrar: produto 64x64 -> 128 bits com as metades combinadas por
+   xor (a mistura do wyhash); sem __int128, o mesmo valor por produtos parciais */
+static inline uint64_t multiplicarDobrar(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = (unsigned __int128) a * b;
+    return (uint64_t) r ^ (uint64_t) (r >> 64);
+#else
+    uint64_t aBaixo = (uint32_t) a, aAlto = a >> 32, bBaixo = (uint32_t) b, bAlto = b >> 32;
+    uint64_t bb = aBaixo * bBaixo, ba = aBaixo * bAlto, ab = aAlto * bBaixo, aa = aAlto * bAlto;
+    uint64_t meio = (bb >> 32) + (uint32_t) ba + (uint32_t) ab;
+    return ((meio << 32) | (uint32_t) bb) ^ (aa + (ba >> 32) + (ab >> 32) + (meio >> 32));
+#endif
+}
+
+/* hashChave: 16 bytes por multiplicação, no estilo do wyhash. O tamanho vem
+   do strlen da libc (vetorizado) e as palavras são lidas com memcpy, sem ler
+   além do terminador; o djb2 fazia uma multiplicação dependente por byte.
+   Os 32 bits devolvidos são bem misturados também nos bits baixos (máscara). */
+static unsigned int hashChave(const char *chave) {
+    const unsigned char *p = (const unsigned char*) chave;
+    size_t n = strlen(chave);
+    uint64_t h = 0xa0761d6478bd642fULL ^ n, a = 0, b = 0;
+    for (; n > 16; p += 16, n -= 16) {
+        memcpy(&a, p, 8);
+        memcpy(&b, p + 8, 8);
+        h = multiplicarDobrar(a ^ 0xe7037ed1a0b428dbULL, b ^ h);
     }
-    /* não encontrou, cria novo entry */
-    HashEntry *entry = (HashEntry*) malloc(sizeof(HashEntry));
-    if (!entry) { fprintf(stderr, "Erro hash malloc\n"); exit(EXIT_FAILURE); }
-    strncpy(entry->pista, pista, MAX_NAME-1);
-    entry->pista[MAX_NAME-1] = '\0';
-    strncpy(entry->suspeito, suspeito, MAX_NAME-1);
-    entry->suspeito[MAX_NAME-1] = '\0';
-    entry->prox = ht->buckets[key];
-    ht->buckets[key] = entry;
+    a = b = 0;
+    if (n > 8) { memcpy(&a, p, 8); memcpy(&b, p + 8, n - 8); }
+    else memcpy(&a, p, n);
+    h = multiplicarDobrar(a ^ 0x8ebc6af09c88c6e3ULL, b ^ h ^ 0x589965cc75374cc3ULL);
+    h = multiplicarDobrar(h ^ 0xe7037ed1a0b428dbULL, h ^ 0xa0761d6478bd642fULL);
+    return (unsigned int) (h ^ (h >> 32));
 }
 
-/* encontrarSuspeito: retorna ponteiro interno para nome do suspeito ou NULL */
-const char* encontrarSuspeito(HashTable *ht, const char *pista) {
-    if (!pista) return NULL;
-    unsigned long key = hash_djb2(pista);
-    HashEntry *cur = ht->buckets[key];
-    while (cur) {
-        if (strcmp(cur->pista, pista) == 0) {
-            return cur->suspeito;
+/* texto: acesso ao texto de um StrId (ponteiro válido até a próxima internação) */
+static inline const char* texto(const PoolStrings *ps, StrId id) {
+    return ps->dados + id;
+}
+
+/* inicializarPool: pool contendo só a string vazia (StrId 0) */
+void inicializarPool(PoolStrings *ps) {
+    ps->cap = 4096;
+    ps->dados = (char*) malloc(ps->cap);
+    ESTAT_ALOC(EST_POOL, ps->cap);
+    if (!ps->dados) { fprintf(stderr, "Erro de memória (strings)\n"); exit(EXIT_FAILURE); }
+    ps->dados[0] = '\0';
+    ps->usado = 1;
+    ps->indice = NULL;
+    ps->capIndice = 0;
+    ps->qtd = 0;
+}
+
+/* indexarPool: monta o índice percorrendo os textos já presentes (pool carregado de arquivo) */
+static void indexarPool(PoolStrings *ps) {
+    size_t qtd = 0;
+    for (size_t off = 1; off < ps->usado; off += strlen(ps->dados + off) + 1) qtd++;
+    ps->capIndice = potenciaDe2(qtd * 2 + 2);
+    ps->indice = (StrId*) calloc(ps->capIndice, sizeof(StrId));
+    ESTAT_ALOC(EST_POOL, ps->capIndice * sizeof(StrId));
+    if (!ps->indice) { fprintf(stderr, "Erro de memória (strings)\n"); exit(EXIT_FAILURE); }
+    ps->qtd = 0;
+    for (size_t off = 1; off < ps->usado; off += strlen(ps->dados + off) + 1) {
+        size_t i = hashChave(ps->dados + off) & (ps->capIndice - 1);
+        while (ps->indice[i]) {
+            if (strcmp(texto(ps, ps->indice[i]), ps->dados + off) == 0) break; /* repetido */
+            i = (i + 1) & (ps->capIndice - 1);
         }
-        cur = cur->prox;
+        if (ps->indice[i]) continue;
+        ps->indice[i] = (StrId) off;
+        ps->qtd++;
     }
-    return NULL;
 }
 
-/* explorarSalas: interação com o jogador; mantém pilha para voltar */
-void explorarSalas(Sala *raiz, BSTNode **raizPistas, HashTable *ht) {
-    if (!raiz) return;
+/* buscarString: StrId do texto se já internado; 0 caso contrário */
+StrId buscarString(PoolStrings *ps, const char *t) {
+    if (!t || t[0] == '\0') return 0;
+    if (!ps->indice && ps->usado > 1) indexarPool(ps);
+    if (ps->capIndice == 0) return 0;
+    size_t mask = ps->capIndice - 1;
+    size_t i = hashChave(t) & mask;
+    while (ps->indice[i]) {
+        if (strcmp(texto(ps, ps->indice[i]), t) == 0) return ps->indice[i];
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
 
-    Sala *pilha[STACK_MAX];
-    int topo = -1;       /* -1 = vazio */
-    Sala *atual = raiz;
-    char entrada[16];
+/* internarString: devolve o StrId do texto, copiando-o para o pool na primeira vez */
+StrId internarString(PoolStrings *ps, const char *t) {
+    if (!t || t[0] == '\0') return 0;
+    StrId id = buscarString(ps, t);
+    if (id) return id;
 
-    while (1) {
-        printf("\nVocê está em: %s\n", atual->nome);
-
-        /* coleta de pista, se existir */
-        if (atual->pista[0] != '\0') {
-            BSTNode *n = buscarPistaNode(*raizPistas, atual->pista);
-            if (!n) {
-                printf("Você encontrou uma pista: \"%s\"\n", atual->pista);
-                *raizPistas = inserirPista(*raizPistas, atual->pista);
-            } else {
-                printf("Você já coletou a pista aqui: \"%s\" (já coletada %d vez(es)).\n",
-                       n->pista, n->contador);
-                /* se desejar, poderia incrementar novamente ao revisitar; aqui não incrementa */
-            }
+    size_t len = strlen(t) + 1;
+    if (ps->cap == 0) {
+        /* textos mapeados de arquivo: passa a ter cópia própria antes de crescer */
+        size_t cap = potenciaDe2(ps->usado + len);
+        char *d = (char*) malloc(cap);
+        ESTAT_ALOC(EST_POOL, cap);
+        if (!d) { fprintf(stderr, "Erro de memória (strings)\n"); exit(EXIT_FAILURE); }
+        memcpy(d, ps->dados, ps->usado);
+        ps->dados = d;
+        ps->cap = cap;
+    }
+    if (ps->usado + len > UINT32_MAX) {
+        fprintf(stderr, "Erro: pool de strings excedeu 4 GiB\n");
+        exit(EXIT_FAILURE);
+    }
+    if (ps->usado + len > ps->cap) {
+        size_t nova = ps->cap * 2;
+        while (nova < ps->usado + len) nova *= 2;
+        char *d = (char*) realloc(ps->dados, nova);
+        ESTAT_ALOC(EST_POOL, nova);
+        if (!d) { fprintf(stderr, "Erro de memória (strings)\n"); exit(EXIT_FAILURE); }
+        ps->dados = d;
+        ps->cap = nova;
+    }
+    /* índice com carga <= 1/2; ao crescer, reinsere todos os deslocamentos */
+    if ((ps->qtd + 1) * 2 > ps->capIndice) {
+        size_t novaCap = potenciaDe2((ps->qtd + 1) * 4);
+        StrId *novo = (StrId*) calloc(novaCap, sizeof(StrId));
+        ESTAT_ALOC(EST_POOL, novaCap * sizeof(StrId));
+        if (!novo) { fprintf(stderr, "Erro de memória (strings)\n"); exit(EXIT_FAILURE); }
+        for (size_t k = 0; k < ps->capIndice; ++k) {
+            StrId v = ps->indice[k];
+            if (!v) continue;
+            size_t i = hashChave(texto(ps, v)) & (novaCap - 1);
+            while (novo[i]) i = (i + 1) & (novaCap - 1);
+            novo[i] = v;
+        }
+        free(ps->indice);
+        ps->indice = novo;
+        ps->capIndice = novaCap;
+    }
+    id = (StrId) ps->usado;
+    memcpy(ps->dados + ps->usado, t, len);
+    ps->usado += len;
+    size_t i = hashChave(t) & (ps->capIndice - 1);
+    while (ps->indice[i]) i = (i + 1) & (ps->capIndice - 1);
+    ps->indice[i] = id;
+    ps->qtd++;
+    return id;
+}
 
-            const char *s = encontrarSuspeito(ht, atual->pista);
-            if (s)
-                printf("-> Esta pista aponta para: %s\n", s);
-            else
-                printf("-> Esta pista não está associada a nenhum suspeito conhecido.\n");
-        } else {
-            printf("Nenhuma pista aparente nesta sala.\n");
+/* reservarPool: garante espaço para 'bytes' de texto e 'qtdStrings' no índice
+   sem realocações intermediárias (usado antes de cargas em massa) */
+void reservarPool(PoolStrings *ps, size_t bytes, size_t qtdStrings) {
+    if (!ps->indice && ps->usado > 1) indexarPool(ps);
+    if (ps->cap && ps->usado + bytes > ps->cap) {
+        char *d = (char*) realloc(ps->dados, ps->usado + bytes);
+        ESTAT_ALOC(EST_POOL, ps->usado + bytes);
+        if (!d) { fprintf(stderr, "Erro de memória (strings)\n"); exit(EXIT_FAILURE); }
+        ps->dados = d;
+        ps->cap = ps->usado + bytes;
+    }
+    size_t capIndice = potenciaDe2((ps->qtd + qtdStrings) * 2 + 2);
+    if (capIndice > ps->capIndice) {
+        StrId *novo = (StrId*) calloc(capIndice, sizeof(StrId));
+        ESTAT_ALOC(EST_POOL, capIndice * sizeof(StrId));
+        if (!novo) { fprintf(stderr, "Erro de memória (strings)\n"); exit(EXIT_FAILURE); }
+        for (size_t k = 0; k < ps->capIndice; ++k) {
+            StrId v = ps->indice[k];
+            if (!v) continue;
+            size_t i = hashChave(texto(ps, v)) & (capIndice - 1);
+            while (novo[i]) i = (i + 1) & (capIndice - 1);
+            novo[i] = v;
         }
+        free(ps->indice);
+        ps->indice = novo;
+        ps->capIndice = capIndice;
+    }
+}
 
-        /* Opções de movimento (inclui 'b' para voltar quando possível) */
-        printf("\nOpções de movimento:\n");
-        if (atual->esquerda) printf(" - (e) Ir para %s\n", atual->esquerda->nome);
-        if (atual->direita) printf(" - (d) Ir para %s\n", atual->direita->nome);
-        if (topo >= 0) printf(" - (b) Voltar para %s\n", pilha[topo]->nome);
-        printf(" - (s) Sair da exploração\n");
-        printf("Escolha: ");
+/* liberarPool: libera textos (se próprios) e índice */
+void liberarPool(PoolStrings *ps) {
+    if (ps->cap) free(ps->dados);
+    free(ps->indice);
+    memset(ps, 0, sizeof *ps);
+}
 
-        if (scanf("%15s", entrada) != 1) {
-            int c;
-            while ((c = getchar()) != '\n' && c != EOF) {}
-            printf("Entrada inválida. Tente novamente.\n");
-            continue;
-        }
+/* inicializarMansao: mansão vazia cujos textos serão internados em 'ps' */
+void inicializarMansao(Mansao *m, PoolStrings *ps) {
+    m->salas = NULL;
+    m->qtd = m->cap = 0;
+    m->strings = ps;
+    m->mapa = NULL;
+    m->tamMapa = 0;
+    memset(&m->nomes, 0, sizeof m->nomes);
+    m->salaDoNome = NULL;
+    m->pai = NULL;
+    m->ordemNomes = NULL;
+    m->indiceMapeado = 0;
+    m->passagens = NULL;
+    m->qtdPassagens = m->capPassagens = 0;
+    m->inicioVizinhos = m->vizinhos = NULL;
+}
 
-        if (strcmp(entrada, "e") == 0 || strcmp(entrada, "E") == 0) {
-            if (atual->esquerda) {
-                /* empilha atual e vai para esquerda */
-                if (topo + 1 >= STACK_MAX) {
-                    printf("Impossível empilhar mais (limite). Ação cancelada.\n");
-                } else {
-                    pilha[++topo] = atual;
-                    atual = atual->esquerda;
-                }
-            } else {
-                printf("Caminho à esquerda inexistente.\n");
-            }
-        } else if (strcmp(entrada, "d") == 0 || strcmp(entrada, "D") == 0) {
-            if (atual->direita) {
-                if (topo + 1 >= STACK_MAX) {
-                    printf("Impossível empilhar mais (limite). Ação cancelada.\n");
-                } else {
-                    pilha[++topo] = atual;
-                    atual = atual->direita;
-                }
-            } else {
-                printf("Caminho à direita inexistente.\n");
-            }
-        } else if (strcmp(entrada, "b") == 0 || strcmp(entrada, "B") == 0) {
-            if (topo >= 0) {
-                atual = pilha[topo--]; /* desempilha */
-            } else {
-                printf("Não há sala anterior para voltar.\n");
-            }
-        } else if (strcmp(entrada, "s") == 0 || strcmp(entrada, "S") == 0) {
-            printf("Exploração encerrada pelo jogador.\n");
-            break;
-        } else {
-            printf("Opção inválida. Use e, d, b ou s.\n");
+/* criarSala: acrescenta uma sala (sem caminhos) ao vetor do mapa e devolve seu índice */
+uint32_t criarSala(Mansao *m, const char *nome, const char *pista) {
+    if (m->mapa) {
+        fprintf(stderr, "Erro: mansão carregada de arquivo é somente leitura.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (m->qtd == m->cap) {
+        uint32_t nova = m->cap ? m->cap * 2 : 16;
+        if (nova <= m->cap || nova == SALA_NENHUMA) {
+            fprintf(stderr, "Erro: limite de salas atingido.\n");
+            exit(EXIT_FAILURE);
+        }
+        Sala *v = (Sala*) realloc(m->salas, (size_t) nova * sizeof(Sala));
+        ESTAT_ALOC(EST_MANSAO, (size_t) nova * sizeof(Sala));
+        if (!v) {
+            fprintf(stderr, "Erro: falha ao alocar memória para sala.\n");
+            exit(EXIT_FAILURE);
         }
+        m->salas = v;
+        m->cap = nova;
     }
+    Sala *s = &m->salas[m->qtd];
+    s->nome = internarString(m->strings, nome);
+    s->pista = internarString(m->strings, pista);
+    s->esquerda = s->direita = SALA_NENHUMA;
+    return m->qtd++;
 }
 
-/* imprimirPistasComContagem: imprime as pistas coletadas em ordem e mostra suspeito relacionado */
-void imprimirPistasComContagem(BSTNode *raiz, HashTable *ht) {
-    if (!raiz) return;
-    imprimirPistasComContagem(raiz->esq, ht);
-    const char *sus = encontrarSuspeito(ht, raiz->pista);
-    if (sus)
-        printf(" - \"%s\" (coletada %d vez(es)) => aponta para: %s\n", raiz->pista, raiz->contador, sus);
-    else
-        printf(" - \"%s\" (coletada %d vez(es)) => aponta para: (nenhum)\n", raiz->pista, raiz->contador);
-    imprimirPistasComContagem(raiz->dir, ht);
-}
-
-/* coletarSuspeitosUnicos: preenche array com nomes únicos de suspeitos encontrados na hash */
-void coletarSuspeitosUnicos(HashTable *ht, char nomes[][MAX_NAME], int *qtd) {
-    *qtd = 0;
-    for (int i = 0; i < HASH_SIZE; ++i) {
-        for (HashEntry *e = ht->buckets[i]; e; e = e->prox) {
-            /* verificar se já está na lista */
-            int encontrado = 0;
-            for (int k = 0; k < *qtd; ++k) {
-                if (strcmp(nomes[k], e->suspeito) == 0) { encontrado = 1; break; }
-            }
-            if (!encontrado) {
-                strncpy(nomes[*qtd], e->suspeito, MAX_NAME-1);
-                nomes[*qtd][MAX_NAME-1] = '\0';
-                (*qtd)++;
-                if (*qtd >= HASH_SIZE) return; /* segurança */
-            }
+/* conectarSalas: define os caminhos à esquerda/direita (SALA_NENHUMA = nenhum) */
+void conectarSalas(Mansao *m, uint32_t sala, uint32_t esquerda, uint32_t direita) {
+    m->salas[sala].esquerda = esquerda;
+    m->salas[sala].direita = direita;
+}
+
+/* conectarPassagem: acrescenta uma passagem de mão dupla entre duas salas */
+void conectarPassagem(Mansao *m, uint32_t a, uint32_t b) {
+    if (m->mapa) {
+        fprintf(stderr, "Erro: mansão carregada de arquivo é somente leitura.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (m->qtdPassagens == m->capPassagens) {
+        uint32_t nova = m->capPassagens ? m->capPassagens * 2 : 16;
+        Passagem *v = (Passagem*) realloc(m->passagens, (size_t) nova * sizeof(Passagem));
+        ESTAT_ALOC(EST_MANSAO, (size_t) nova * sizeof(Passagem));
+        if (!v || nova <= m->capPassagens) {
+            fprintf(stderr, "Erro: falha ao alocar memória para passagem.\n");
+            exit(EXIT_FAILURE);
         }
+        m->passagens = v;
+        m->capPassagens = nova;
+    }
+    m->passagens[m->qtdPassagens].a = a;
+    m->passagens[m->qtdPassagens].b = b;
+    m->qtdPassagens++;
+}
+
+/* contarAresta / gravarAresta: duas passadas do CSR (graus, depois vizinhos) */
+static void contarAresta(uint32_t *grau, uint32_t de, uint32_t para) {
+    if (para != SALA_NENHUMA && para != de) { grau[de + 1]++; grau[para + 1]++; }
+}
+
+static void gravarAresta(const uint32_t *ini, uint32_t *pos, uint32_t *viz, uint32_t de, uint32_t para) {
+    if (para == SALA_NENHUMA || para == de) return;
+    viz[ini[de] + pos[de]++] = para;
+    viz[ini[para] + pos[para]++] = de;
+}
+
+/* calcularPais: preenche pai[0 .. qtd). Em mapas que não são árvore, o pai
+   é a sala de menor índice com caminho até ela */
+static void calcularPais(const Sala *salas, uint32_t qtd, uint32_t *pai) {
+    for (uint32_t i = 0; i < qtd; ++i) pai[i] = SALA_NENHUMA;
+    for (uint32_t i = 0; i < qtd; ++i) {
+        const Sala *s = &salas[i];
+        /* o Hall é a raiz: um caminho de volta até ele não o torna filho */
+        if (s->esquerda != SALA_NENHUMA && s->esquerda != 0 && pai[s->esquerda] == SALA_NENHUMA)
+            pai[s->esquerda] = i;
+        if (s->direita != SALA_NENHUMA && s->direita != 0 && pai[s->direita] == SALA_NENHUMA)
+            pai[s->direita] = i;
     }
 }
 
-/* imprime lista de suspeitos conhecidos */
-void imprimirSuspeitos(HashTable *ht) {
-    char nomes[HASH_SIZE][MAX_NAME];
-    int qtd = 0;
-    coletarSuspeitosUnicos(ht, nomes, &qtd);
-    if (qtd == 0) {
-        printf("Nenhum suspeito registrado no sistema.\n");
+/* ordenarSalasPorNome: mergesort estável dos índices pelo nome da sala
+   (empates ficam em ordem de índice); usado só na gravação do arquivo */
+static void ordenarSalasPorNome(const Mansao *m, uint32_t *v, uint32_t *tmp, size_t n) {
+    const PoolStrings *ps = m->strings;
+    if (n <= 16) {
+        for (size_t i = 1; i < n; ++i) {
+            uint32_t x = v[i];
+            size_t j = i;
+            for (; j > 0 && strcmp(texto(ps, m->salas[v[j - 1]].nome), texto(ps, m->salas[x].nome)) > 0; --j)
+                v[j] = v[j - 1];
+            v[j] = x;
+        }
         return;
     }
-    printf("\nSuspeitos conhecidos:\n");
-    for (int i = 0; i < qtd; ++i) {
-        printf(" %d) %s\n", i+1, nomes[i]);
+    size_t meio = n / 2;
+    ordenarSalasPorNome(m, v, tmp, meio);
+    ordenarSalasPorNome(m, v + meio, tmp, n - meio);
+    size_t i = 0, j = meio, k = 0;
+    while (i < meio && j < n)
+        tmp[k++] = strcmp(texto(ps, m->salas[v[j]].nome), texto(ps, m->salas[v[i]].nome)) < 0 ? v[j++] : v[i++];
+    while (i < meio) tmp[k++] = v[i++];
+    memcpy(v, tmp, k * sizeof(uint32_t)); /* o resto de [j, n) já está no lugar */
+}
+
+/* montarGrafo: lista de adjacência (CSR) em vetores novos, O(salas + passagens):
+   arestas da árvore nos dois sentidos e passagens; os vizinhos de cada sala
+   ficam contíguos (esquerda/direita primeiro, na ordem das salas). Devolve o
+   vetor de inícios; os vizinhos vão para *vizinhos. */
+static uint32_t* montarGrafo(const Mansao *m, uint32_t **vizinhos) {
+    uint32_t *ini = (uint32_t*) calloc((size_t) m->qtd + 1, sizeof(uint32_t));
+    if (!ini) { fprintf(stderr, "Erro de memória (grafo da mansão)\n"); exit(EXIT_FAILURE); }
+    for (uint32_t i = 0; i < m->qtd; ++i) {
+        contarAresta(ini, i, m->salas[i].esquerda);
+        contarAresta(ini, i, m->salas[i].direita);
+    }
+    for (uint32_t k = 0; k < m->qtdPassagens; ++k)
+        contarAresta(ini, m->passagens[k].a, m->passagens[k].b);
+    for (uint32_t i = 0; i < m->qtd; ++i) ini[i + 1] += ini[i];
+    size_t arestas = ini[m->qtd];
+    uint32_t *viz = (uint32_t*) malloc((arestas ? arestas : 1) * sizeof(uint32_t));
+    uint32_t *pos = (uint32_t*) calloc((size_t) m->qtd + 1, sizeof(uint32_t));
+    ESTAT_ALOC(EST_MANSAO, ((size_t) m->qtd + 1 + arestas) * sizeof(uint32_t));
+    if (!viz || !pos) { fprintf(stderr, "Erro de memória (grafo da mansão)\n"); exit(EXIT_FAILURE); }
+    for (uint32_t i = 0; i < m->qtd; ++i) {
+        gravarAresta(ini, pos, viz, i, m->salas[i].esquerda);
+        gravarAresta(ini, pos, viz, i, m->salas[i].direita);
     }
+    for (uint32_t k = 0; k < m->qtdPassagens; ++k)
+        gravarAresta(ini, pos, viz, m->passagens[k].a, m->passagens[k].b);
+    free(pos);
+    *vizinhos = viz;
+    return ini;
 }
 
-/* contadorPistasParaSuspeito: percorre BST e soma contadores de pistas que apontam para 'suspeito' */
-static int contadorPistasParaSuspeito(BSTNode *raiz, HashTable *ht, const char *suspeito) {
-    if (!raiz) return 0;
-    int total = 0;
-    total += contadorPistasParaSuspeito(raiz->esq, ht, suspeito);
-    const char *s = encontrarSuspeito(ht, raiz->pista);
-    if (s && strcmp(s, suspeito) == 0) total += raiz->contador;
-    total += contadorPistasParaSuspeito(raiz->dir, ht, suspeito);
-    return total;
+/* indexarMansao: monta, em O(salas + passagens), o índice nome -> sala, o
+   vetor de pais e o grafo, em memória (um índice mapeado de arquivo é trocado).
+   Deve ser chamada com o mapa completo (salas criadas depois não entram). */
+void indexarMansao(Mansao *m) {
+    if (m->indiceMapeado) {
+        m->pai = m->ordemNomes = m->inicioVizinhos = m->vizinhos = NULL;
+        m->indiceMapeado = 0;
+    }
+    liberarSimbolos(&m->nomes);
+    free(m->salaDoNome);
+    free(m->pai);
+    m->salaDoNome = (uint32_t*) malloc(((size_t) m->qtd + 1) * sizeof(uint32_t));
+    m->pai = (uint32_t*) malloc(((size_t) m->qtd + 1) * sizeof(uint32_t));
+    ESTAT_ALOC(EST_MANSAO, 2 * ((size_t) m->qtd + 1) * sizeof(uint32_t));
+    if (!m->salaDoNome || !m->pai) {
+        fprintf(stderr, "Erro de memória (índice da mansão)\n");
+        exit(EXIT_FAILURE);
+    }
+    calcularPais(m->salas, m->qtd, m->pai);
+    for (uint32_t i = 0; i < m->qtd; ++i) {
+        size_t antes = m->nomes.qtd;
+        int id = internarSimbolo(&m->nomes, m->salas[i].nome);
+        if (m->nomes.qtd != antes) m->salaDoNome[id] = i;
+    }
+    free(m->inicioVizinhos);
+    free(m->vizinhos);
+    m->inicioVizinhos = montarGrafo(m, &m->vizinhos);
 }
 
-/* verificarSuspeitoFinal: mostra resumo, lista suspeitos e pede acusação */
-void verificarSuspeitoFinal(BSTNode *raizPistas, HashTable *ht) {
-    printf("\n========= RESUMO DA INVESTIGAÇÃO =========\n");
+/* buscarSalaPorNome: índice da sala pelo nome; O(1) esperado com o índice em
+   memória, O(log salas) comparações na ordem de nomes de um arquivo v5 */
+uint32_t buscarSalaPorNome(const Mansao *m, const char *nome) {
+    if (m->ordemNomes) {
+        if (!nome || nome[0] == '\0') return SALA_NENHUMA;
+        size_t ini = 0, fim = m->qtd;
+        while (ini < fim) { /* primeira posição com nome >= 'nome': a sala de menor índice */
+            size_t meio = ini + (fim - ini) / 2;
+            if (strcmp(texto(m->strings, m->salas[m->ordemNomes[meio]].nome), nome) < 0) ini = meio + 1;
+            else fim = meio;
+        }
+        return ini < m->qtd && strcmp(texto(m->strings, m->salas[m->ordemNomes[ini]].nome), nome) == 0
+               ? m->ordemNomes[ini] : SALA_NENHUMA;
+    }
+    if (!m->salaDoNome) return SALA_NENHUMA;
+    StrId s = buscarString(m->strings, nome);
+    if (s == 0) return SALA_NENHUMA;
+    int id = buscarSimbolo(&m->nomes, s);
+    return id < 0 ? SALA_NENHUMA : m->salaDoNome[id];
+}
 
-    if (!raizPistas) {
-        printf("Você não coletou nenhuma pista durante a exploração.\n");
-    } else {
-        printf("Pistas coletadas:\n");
-        imprimirPistasComContagem(raizPistas, ht);
+/* salaPai: sala de onde se chega à sala dada (SALA_NENHUMA para o Hall) */
+uint32_t salaPai(const Mansao *m, uint32_t sala) {
+    return (m->pai && sala < m->qtd) ? m->pai[sala] : SALA_NENHUMA;
+}
+
+/* liberarMansao: libera o vetor de salas (ou desfaz o mapeamento do arquivo) e o índice */
+void liberarMansao(Mansao *m) {
+    if (m->mapa) munmap(m->mapa, m->tamMapa);
+    else { free(m->salas); free(m->passagens); }
+    liberarSimbolos(&m->nomes);
+    free(m->salaDoNome);
+    if (!m->indiceMapeado) {
+        free(m->pai);
+        free(m->inicioVizinhos);
+        free(m->vizinhos);
     }
+    inicializarMansao(m, m->strings);
+}
 
-    /* Mostrar suspeitos conhecidos */
-    imprimirSuspeitos(ht);
+/* auxiliares AVL: altura de um nó (NULL = 0) e recálculo após mudança nos filhos */
+static int alturaNo(const BSTNode *n) {
+    return n ? n->altura : 0;
+}
 
-    /* Perguntar pelo acusado */
-    char acusado[MAX_NAME];
-    printf("\nDigite o nome do suspeito que deseja acusar (ou deixe em branco para não acusar): ");
-    /* limpar buffer até newline anterior */
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF) {}
-    if (fgets(acusado, sizeof(acusado), stdin) == NULL) {
-        printf("Entrada inválida.\n");
-        return;
+static void atualizarAltura(BSTNode *n) {
+    int he = alturaNo(n->esq), hd = alturaNo(n->dir);
+    n->altura = 1 + (he > hd ? he : hd);
+}
+
+/* rotações simples; retornam a nova raiz da subárvore */
+static BSTNode* rotacaoDireita(BSTNode *y) {
+    BSTNode *x = y->esq;
+    y->esq = x->dir;
+    x->dir = y;
+    atualizarAltura(y);
+    atualizarAltura(x);
+    return x;
+}
+
+static BSTNode* rotacaoEsquerda(BSTNode *x) {
+    BSTNode *y = x->dir;
+    x->dir = y->esq;
+    y->esq = x;
+    atualizarAltura(x);
+    atualizarAltura(y);
+    return y;
+}
+
+/* balancear: restaura |fator| <= 1 na raiz da subárvore (rotações simples ou duplas) */
+static BSTNode* balancear(BSTNode *n) {
+    atualizarAltura(n);
+    int fator = alturaNo(n->esq) - alturaNo(n->dir);
+    if (fator > 1) {
+        if (alturaNo(n->esq->esq) < alturaNo(n->esq->dir))
+            n->esq = rotacaoEsquerda(n->esq);
+        return rotacaoDireita(n);
     }
-    /* remover newline */
-    size_t len = strlen(acusado);
-    if (len > 0 && acusado[len-1] == '\n') acusado[len-1] = '\0';
+    if (fator < -1) {
+        if (alturaNo(n->dir->dir) < alturaNo(n->dir->esq))
+            n->dir = rotacaoDireita(n->dir);
+        return rotacaoEsquerda(n);
+    }
+    return n;
+}
 
-    if (acusado[0] == '\0') {
-        printf("Nenhuma acusação realizada. Investigação encerrada.\n");
-        return;
+/* inserirPista: insere pista na BST; se existir, incrementa contador. Devolve a
+   raiz; em *no (opcional), o nó da pista, para o chamador não descer de novo.
+   Descida iterativa guardando os elos percorridos numa pilha limitada e
+   rebalanceamento AVL na volta; para quando a altura de uma subárvore não
+   muda (os ancestrais não são afetados). Profundidade O(log n), sem recursão. */
+BSTNode* inserirPista(Arena *arena, const PoolStrings *ps, BSTNode *raiz, StrId pista, int suspeito,
+                      BSTNode **no) {
+    if (no) *no = NULL;
+    if (pista == 0) return raiz;
+    BSTNode **caminho[BST_ALTURA_MAX]; /* endereço do ponteiro para cada nó visitado */
+    int topo = 0;
+    BSTNode **elo = &raiz;
+    const char *t = texto(ps, pista);
+    while (*elo) {
+        BSTNode *n = *elo;
+        ESTAT(estatLocal.nosInsercao++);
+        /* textos internados: StrId igual <=> texto igual; a ordem continua alfabética */
+        int cmp = (pista == n->pista) ? 0 : strcmp(t, texto(ps, n->pista));
+        if (cmp == 0) {
+            ESTAT(estatLocal.insercoesBST++);
+            if (n->contador < INT_MAX) n->contador += 1; /* duplicata; formato da árvore não muda */
+            if (no) *no = n;
+            return raiz;
+        }
+        if (topo == BST_ALTURA_MAX) {
+            fprintf(stderr, "Erro: BST mais alta que BST_ALTURA_MAX.\n");
+            exit(EXIT_FAILURE);
+        }
+        caminho[topo++] = elo;
+        elo = (cmp < 0) ? &n->esq : &n->dir;
     }
 
-    int cont = contadorPistasParaSuspeito(raizPistas, ht, acusado);
-    printf("\nPistas que apontam para '%s': %d\n", acusado, cont);
-    if (cont >= 2) {
-        printf("Acusação válida: existem evidências suficientes para prender %s.\n", acusado);
-    } else {
-        printf("Acusação fraca: não há pistas suficientes para culpar %s.\n", acusado);
+    ESTAT(estatLocal.insercoesBST++);
+    BSTNode *n = (BSTNode*) arenaAlocar(arena, sizeof(BSTNode));
+    n->pista = pista;
+    n->contador = 1;
+    n->altura = 1;
+    n->suspeito = suspeito;
+    n->esq = n->dir = NULL;
+    *elo = n;
+    if (no) *no = n;
+
+    while (topo > 0) {
+        BSTNode **p = caminho[--topo];
+        int alturaAntes = (*p)->altura;
+        *p = balancear(*p);
+        if ((*p)->altura == alturaAntes) break;
+    }
+    return raiz;
+}
+
+/* buscarPistaNode: retorna nó se existir (descida iterativa) */
+BSTNode* buscarPistaNode(const PoolStrings *ps, BSTNode *raiz, const char *pista) {
+    if (!pista) return NULL;
+    ESTAT(estatLocal.buscasBST++);
+    while (raiz) {
+        ESTAT(estatLocal.nosBusca++);
+        int cmp = strcmp(pista, texto(ps, raiz->pista));
+        if (cmp == 0) return raiz;
+        raiz = (cmp < 0) ? raiz->esq : raiz->dir;
     }
+    return NULL;
 }
 
-/* liberarBST: libera memória da BST */
-void liberarBST(BSTNode *raiz) {
-    if (!raiz) return;
-    liberarBST(raiz->esq);
-    liberarBST(raiz->dir);
-    free(raiz);
+/* alturaFaixa: altura da árvore montada pelo meio de uma faixa de k nós (bits de k) */
+static int alturaFaixa(size_t k) {
+    int h = 0;
+    for (; k; k >>= 1) h++;
+    return h;
 }
 
-/* liberarArvore: libera memória da árvore de salas */
-void liberarArvore(Sala *raiz) {
-    if (!raiz) return;
-    liberarArvore(raiz->esquerda);
-    liberarArvore(raiz->direita);
-    free(raiz);
+/* montarBalanceada: nós já em ordem num vetor contíguo -> AVL perfeitamente
+   balanceada (o meio de cada faixa é a raiz), sem comparações nem recursão */
+static BSTNode* montarBalanceada(BSTNode *nos, size_t n) {
+    struct { size_t ini, fim; BSTNode **ligacao; } pilha[2 * BST_ALTURA_MAX];
+    int topo = 0;
+    BSTNode *raiz = NULL;
+    if (n) { pilha[0].ini = 0; pilha[0].fim = n; pilha[0].ligacao = &raiz; topo = 1; }
+    while (topo > 0) {
+        size_t ini = pilha[--topo].ini, fim = pilha[topo].fim;
+        BSTNode **ligacao = pilha[topo].ligacao;
+        size_t meio = ini + (fim - ini) / 2;
+        BSTNode *x = &nos[meio];
+        x->altura = alturaFaixa(fim - ini);
+        x->esq = x->dir = NULL;
+        *ligacao = x;
+        if (meio + 1 < fim) { pilha[topo].ini = meio + 1; pilha[topo].fim = fim; pilha[topo].ligacao = &x->dir; topo++; }
+        if (ini < meio) { pilha[topo].ini = ini; pilha[topo].fim = meio; pilha[topo].ligacao = &x->esq; topo++; }
+    }
+    return raiz;
 }
 
-/* liberarHash: libera todas entradas da hash */
-void liberarHash(HashTable *ht) {
-    for (int i = 0; i < HASH_SIZE; ++i) {
-        HashEntry *cur = ht->buckets[i];
-        while (cur) {
-            HashEntry *prox = cur->prox;
-            free(cur);
-            cur = prox;
+/* buscarPistasPorPrefixo: a BST está em ordem de strcmp, então as pistas com o
+   prefixo formam um intervalo contíguo: desce até a primeira >= prefixo e segue
+   em ordem enquanto o prefixo casar. O(altura + resultados). */
+size_t buscarPistasPorPrefixo(const PoolStrings *ps, const BSTNode *raiz, const char *prefixo,
+                              StrId *saida, size_t max) {
+    const BSTNode *pilha[BST_ALTURA_MAX];
+    int topo = 0;
+    size_t tam = strlen(prefixo), qtd = 0;
+    /* descida até a primeira pista >= prefixo, empilhando onde virou à esquerda */
+    for (const BSTNode *n = raiz; n; ) {
+        if (strcmp(texto(ps, n->pista), prefixo) < 0) { n = n->dir; continue; }
+        pilha[topo++] = n; /* caminho de uma AVL: cabe na pilha */
+        n = n->esq;
+    }
+    while (topo > 0) {
+        const BSTNode *n = pilha[--topo];
+        if (strncmp(texto(ps, n->pista), prefixo, tam) != 0) break; /* saiu do intervalo */
+        if (qtd < max) saida[qtd] = n->pista;
+        qtd++;
+        /* sucessores: tudo à direita já é >= prefixo, dispensa comparar na descida */
+        for (n = n->dir; n; n = n->esq) {
+            if (topo == BST_ALTURA_MAX) {
+                fprintf(stderr, "Erro: BST mais alta que BST_ALTURA_MAX.\n");
+                exit(EXIT_FAILURE);
+            }
+            pilha[topo++] = n;
         }
-        ht->buckets[i] = NULL;
     }
+    return qtd;
 }
 
-/* -------------------- main: monta mapa, hash e roda exploração -------------------- */
+/* trigramaEm: os 3 bytes a partir de 'p' como chave de 24 bits */
+static inline uint32_t trigramaEm(const char *p) {
+    return (uint32_t) (unsigned char) p[0] << 16 | (uint32_t) (unsigned char) p[1] << 8 | (unsigned char) p[2];
+}
 
-int main(void) {
-    setlocale(LC_ALL, "Portuguese");
+/* slotTrigrama: slot da chave na tabela aberta (ocupado por ela ou vazio) */
+static size_t slotTrigrama(const IndiceTrigramas *ix, uint32_t t) {
+    size_t mascara = ix->capTabela - 1;
+    size_t i = (size_t) ((t * 2654435761u) >> 8) & mascara;
+    while (ix->chaves[i] && ix->chaves[i] != t + 1) i = (i + 1) & mascara;
+    return i;
+}
 
-    /* Inicializa tabela hash */
-    HashTable ht;
-    inicializarHash(&ht);
+/* idTrigrama: id denso do trigrama, criando um novo se preciso (carga <= 1/2) */
+static uint32_t idTrigrama(IndiceTrigramas *ix, uint32_t **contagem, size_t *capContagem, uint32_t t) {
+    size_t i = slotTrigrama(ix, t);
+    if (ix->chaves[i]) return ix->ids[i];
+    if (2 * (ix->qtdTrigramas + 1) > ix->capTabela) {
+        size_t nova = ix->capTabela * 2;
+        uint32_t *ch = (uint32_t*) calloc(nova, sizeof(uint32_t));
+        uint32_t *id = (uint32_t*) malloc(nova * sizeof(uint32_t));
+        if (!ch || !id) { fprintf(stderr, "Erro de memória (índice de trigramas)\n"); exit(EXIT_FAILURE); }
+        uint32_t *chAnt = ix->chaves, *idAnt = ix->ids;
+        size_t capAnt = ix->capTabela;
+        ix->chaves = ch;
+        ix->ids = id;
+        ix->capTabela = nova;
+        for (size_t k = 0; k < capAnt; ++k) {
+            if (!chAnt[k]) continue;
+            size_t j = slotTrigrama(ix, chAnt[k] - 1);
+            ix->chaves[j] = chAnt[k];
+            ix->ids[j] = idAnt[k];
+        }
+        free(chAnt);
+        free(idAnt);
+        i = slotTrigrama(ix, t);
+    }
+    if (ix->qtdTrigramas == *capContagem) {
+        size_t nova = *capContagem * 2;
+        uint32_t *c = (uint32_t*) realloc(*contagem, nova * sizeof(uint32_t));
+        if (!c) { fprintf(stderr, "Erro de memória (índice de trigramas)\n"); exit(EXIT_FAILURE); }
+        memset(c + *capContagem, 0, (nova - *capContagem) * sizeof(uint32_t));
+        *contagem = c;
+        *capContagem = nova;
+    }
+    ix->chaves[i] = t + 1;
+    ix->ids[i] = (uint32_t) ix->qtdTrigramas;
+    return (uint32_t) ix->qtdTrigramas++;
+}
 
-    /* Montagem do mapa (árvore de salas) */
-    Sala *hall = criarSala("Hall de Entrada", "pegada barro fora da porta");
-    Sala *salaEstar = criarSala("Sala de Estar", "xícara quebrada");
-    Sala *cozinha = criarSala("Cozinha", "faca limpa no balcão");
-    Sala *biblioteca = criarSala("Biblioteca", "página arrancada do diário");
-    Sala *jardim = criarSala("Jardim", "fio de cabelo loiro");
-    Sala *escritorio = criarSala("Escritório", "bilhete com ameaça");
-    Sala *porao = criarSala("Porão", "pegada barro fora da porta"); /* mesma pista do hall */
-    Sala *quarto = criarSala("Quarto Principal", "anel com inicial gravada");
-    Sala *lavat = criarSala("Lavabo", "mancha de tinta azul");
+/* indexarTrigramas: duas passadas sobre os textos (contagem por trigrama, depois
+   preenchimento do CSR); cada texto entra uma vez na lista de cada trigrama seu */
+void indexarTrigramas(IndiceTrigramas *ix, const PoolStrings *ps, const StrId *textos, size_t qtd) {
+    memset(ix, 0, sizeof *ix);
+    ix->qtd = qtd;
+    ix->capTextos = qtd ? qtd : 1;
+    ix->textos = (StrId*) malloc(ix->capTextos * sizeof(StrId));
+    ix->capTabela = 1024;
+    ix->chaves = (uint32_t*) calloc(ix->capTabela, sizeof(uint32_t));
+    ix->ids = (uint32_t*) malloc(ix->capTabela * sizeof(uint32_t));
+    size_t capContagem = 512;
+    uint32_t *contagem = (uint32_t*) calloc(capContagem, sizeof(uint32_t));
+    uint32_t *ultimo = NULL;    /* [id] = último texto (índice + 1) contado no trigrama */
+    if (!ix->textos || !ix->chaves || !ix->ids || !contagem) {
+        fprintf(stderr, "Erro de memória (índice de trigramas)\n");
+        exit(EXIT_FAILURE);
+    }
+    if (qtd) memcpy(ix->textos, textos, qtd * sizeof(StrId));
 
-    /* Conexões (exemplo): */
-    hall->esquerda = salaEstar;
-    hall->direita = cozinha;
-    salaEstar->esquerda = biblioteca;
-    salaEstar->direita = jardim;
-    cozinha->direita = escritorio;
-    escritorio->direita = porao;
-    biblioteca->esquerda = quarto;
-    biblioteca->direita = lavat;
+    /* 1ª passada: ids dos trigramas e quantos textos contêm cada um */
+    size_t capUltimo = 0;
+    for (size_t i = 0; i < qtd; ++i) {
+        const char *p = texto(ps, textos[i]);
+        size_t tam = strlen(p);
+        for (size_t k = 0; k + 3 <= tam; ++k) {
+            uint32_t id = idTrigrama(ix, &contagem, &capContagem, trigramaEm(p + k));
+            if (capUltimo < capContagem) {
+                uint32_t *u = (uint32_t*) realloc(ultimo, capContagem * sizeof(uint32_t));
+                if (!u) { fprintf(stderr, "Erro de memória (índice de trigramas)\n"); exit(EXIT_FAILURE); }
+                memset(u + capUltimo, 0, (capContagem - capUltimo) * sizeof(uint32_t));
+                ultimo = u;
+                capUltimo = capContagem;
+            }
+            if (ultimo[id] != i + 1) { ultimo[id] = (uint32_t) (i + 1); contagem[id]++; }
+        }
+    }
 
-    /* Inserir associações pista -> suspeito na hash (dados fixos) */
-    inserirNaHash(&ht, "pegada barro fora da porta", "Sr. Morais");
-    inserirNaHash(&ht, "xícara quebrada", "Sra. Duarte");
-    inserirNaHash(&ht, "faca limpa no balcão", "Chef Marco");
-    inserirNaHash(&ht, "página arrancada do diário", "Sra. Duarte");
-    inserirNaHash(&ht, "fio de cabelo loiro", "Jovem Lia");
-    inserirNaHash(&ht, "bilhete com ameaça", "Sr. Morais");
-    inserirNaHash(&ht, "anel com inicial gravada", "Condessa");
-    inserirNaHash(&ht, "mancha de tinta azul", "Pintor Raul");
-
-    /* BST das pistas coletadas (inicialmente vazia) */
-    BSTNode *raizPistas = NULL;
-
-    printf("=== Detective Quest: Sistema de Investigações (versão melhorada) ===\n");
-    printf("Explore a mansão, colete pistas e, ao final, faça sua acusação.\n");
-    printf("Comandos de navegação: e (esquerda), d (direita), b (voltar), s (sair).\n");
+    /* 2ª passada: listas contíguas; 'contagem' vira a próxima posição livre de cada uma */
+    ix->inicio = (uint32_t*) malloc((ix->qtdTrigramas + 1) * sizeof(uint32_t));
+    if (!ix->inicio) { fprintf(stderr, "Erro de memória (índice de trigramas)\n"); exit(EXIT_FAILURE); }
+    size_t total = 0;
+    for (size_t t = 0; t < ix->qtdTrigramas; ++t) {
+        ix->inicio[t] = (uint32_t) total;
+        total += contagem[t];
+        contagem[t] = ix->inicio[t];
+    }
+    ix->inicio[ix->qtdTrigramas] = (uint32_t) total;
+    ix->ocorrencias = (uint32_t*) malloc((total ? total : 1) * sizeof(uint32_t));
+    if (!ix->ocorrencias) { fprintf(stderr, "Erro de memória (índice de trigramas)\n"); exit(EXIT_FAILURE); }
+    if (capUltimo) memset(ultimo, 0, capUltimo * sizeof(uint32_t));
+    for (size_t i = 0; i < qtd; ++i) {
+        const char *p = texto(ps, textos[i]);
+        size_t tam = strlen(p);
+        for (size_t k = 0; k + 3 <= tam; ++k) {
+            uint32_t id = ix->ids[slotTrigrama(ix, trigramaEm(p + k))];
+            if (ultimo[id] != i + 1) { ultimo[id] = (uint32_t) (i + 1); ix->ocorrencias[contagem[id]++] = (uint32_t) i; }
+        }
+    }
+    ix->trigramasCSR = ix->qtdTrigramas;
+    free(contagem);
+    free(ultimo);
+}
+
+/* crescerExtrasTrigramas: vetores por id das listas acrescentadas com folga
+   para mais um trigrama novo (posições novas zeradas) */
+static void crescerExtrasTrigramas(IndiceTrigramas *ix) {
+    size_t nova = 2 * ix->qtdTrigramas + 16;
+    uint32_t *pr = (uint32_t*) realloc(ix->extraPrimeiro, nova * sizeof(uint32_t));
+    if (pr) ix->extraPrimeiro = pr;
+    uint32_t *ul = (uint32_t*) realloc(ix->extraUltimo, nova * sizeof(uint32_t));
+    if (ul) ix->extraUltimo = ul;
+    uint32_t *qt = (uint32_t*) realloc(ix->extraQtd, nova * sizeof(uint32_t));
+    if (qt) ix->extraQtd = qt;
+    if (!pr || !ul || !qt) { fprintf(stderr, "Erro de memória (índice de trigramas)\n"); exit(EXIT_FAILURE); }
+    size_t d = ix->capExtraIds;
+    memset(pr + d, 0, (nova - d) * sizeof(uint32_t));
+    memset(ul + d, 0, (nova - d) * sizeof(uint32_t));
+    memset(qt + d, 0, (nova - d) * sizeof(uint32_t));
+    ix->capExtraIds = nova;
+}
+
+/* acrescentarTrigramas: indexa um texto novo sem refazer o CSR; ele entra no
+   fim da lista ligada de cada trigrama seu (uma vez por trigrama), então as
+   listas continuam em ordem crescente de índice */
+void acrescentarTrigramas(IndiceTrigramas *ix, const PoolStrings *ps, StrId t) {
+    if (ix->qtd == ix->capTextos) {
+        StrId *v = (StrId*) realloc(ix->textos, 2 * ix->capTextos * sizeof(StrId));
+        if (!v) { fprintf(stderr, "Erro de memória (índice de trigramas)\n"); exit(EXIT_FAILURE); }
+        ix->textos = v;
+        ix->capTextos *= 2;
+    }
+    uint32_t i = (uint32_t) ix->qtd;
+    ix->textos[ix->qtd++] = t;
+    const char *p = texto(ps, t);
+    size_t tam = strlen(p);
+    for (size_t k = 0; k + 3 <= tam; ++k) {
+        /* com folga para um id novo, idTrigrama não precisa crescer extraQtd */
+        if (ix->capExtraIds <= ix->qtdTrigramas) crescerExtrasTrigramas(ix);
+        uint32_t id = idTrigrama(ix, &ix->extraQtd, &ix->capExtraIds, trigramaEm(p + k));
+        uint32_t u = ix->extraUltimo[id];
+        if (u && ix->extraTexto[u - 1] == i) continue; /* trigrama repetido no mesmo texto */
+        if (ix->qtdExtras == ix->capExtras) {
+            size_t nova = ix->capExtras ? 2 * ix->capExtras : 64;
+            uint32_t *tx = (uint32_t*) realloc(ix->extraTexto, nova * sizeof(uint32_t));
+            if (tx) ix->extraTexto = tx;
+            uint32_t *px = (uint32_t*) realloc(ix->extraProximo, nova * sizeof(uint32_t));
+            if (px) ix->extraProximo = px;
+            if (!tx || !px) { fprintf(stderr, "Erro de memória (índice de trigramas)\n"); exit(EXIT_FAILURE); }
+            ix->capExtras = nova;
+        }
+        uint32_t e = (uint32_t) ix->qtdExtras++;
+        ix->extraTexto[e] = i;
+        ix->extraProximo[e] = 0;
+        if (u) ix->extraProximo[u - 1] = e + 1;
+        else ix->extraPrimeiro[id] = e + 1;
+        ix->extraUltimo[id] = e + 1;
+        ix->extraQtd[id]++;
+    }
+}
+
+/* tamanhoListaTrigrama: textos com o trigrama 'id' (parte CSR + acrescentados) */
+static size_t tamanhoListaTrigrama(const IndiceTrigramas *ix, uint32_t id) {
+    size_t n = id < ix->trigramasCSR ? ix->inicio[id + 1] - ix->inicio[id] : 0;
+    return n + (id < ix->capExtraIds ? ix->extraQtd[id] : 0);
+}
+
+/* buscarPorTrecho: textos que contêm 'trecho', em ordem de indexação. Com 3+
+   bytes, só os candidatos do trigrama mais raro do trecho são conferidos com
+   strstr. Trechos de 1 ou 2 bytes não formam trigrama: caem na varredura de
+   todos os textos (O(textos indexados)), o único caso que não depende só da
+   saída. */
+size_t buscarPorTrecho(const IndiceTrigramas *ix, const PoolStrings *ps, const char *trecho,
+                       StrId *saida, size_t max) {
+    size_t tam = strlen(trecho), qtd = 0;
+    if (tam < 3) {
+        for (size_t i = 0; i < ix->qtd; ++i) {
+            if (!strstr(texto(ps, ix->textos[i]), trecho)) continue;
+            if (qtd < max) saida[qtd] = ix->textos[i];
+            qtd++;
+        }
+        return qtd;
+    }
+    uint32_t melhor = 0;
+    size_t qtdMelhor = SIZE_MAX;
+    for (size_t k = 0; k + 3 <= tam; ++k) {
+        size_t slot = slotTrigrama(ix, trigramaEm(trecho + k));
+        if (!ix->chaves[slot]) return 0; /* trigrama ausente: nenhum texto contém o trecho */
+        size_t n = tamanhoListaTrigrama(ix, ix->ids[slot]);
+        if (n < qtdMelhor) { melhor = ix->ids[slot]; qtdMelhor = n; }
+    }
+    /* lista do trigrama: parte CSR, depois os acrescentados (índices crescentes) */
+    size_t c = melhor < ix->trigramasCSR ? ix->inicio[melhor] : 0;
+    size_t fim = melhor < ix->trigramasCSR ? ix->inicio[melhor + 1] : 0;
+    uint32_t e = melhor < ix->capExtraIds ? ix->extraPrimeiro[melhor] : 0;
+    while (c < fim || e) {
+        StrId s;
+        if (c < fim) s = ix->textos[ix->ocorrencias[c++]];
+        else { s = ix->textos[ix->extraTexto[e - 1]]; e = ix->extraProximo[e - 1]; }
+        if (tam != 3 && !strstr(texto(ps, s), trecho)) continue; /* com 3 bytes, a lista já é exata */
+        if (qtd < max) saida[qtd] = s;
+        qtd++;
+    }
+    return qtd;
+}
+
+/* liberarTrigramas: libera tabela e listas (CSR e acrescentadas) */
+void liberarTrigramas(IndiceTrigramas *ix) {
+    free(ix->textos);
+    free(ix->chaves);
+    free(ix->ids);
+    free(ix->inicio);
+    free(ix->ocorrencias);
+    free(ix->extraPrimeiro);
+    free(ix->extraUltimo);
+    free(ix->extraQtd);
+    free(ix->extraTexto);
+    free(ix->extraProximo);
+    memset(ix, 0, sizeof *ix);
+}
+
+/* alocarSlots: bloco de slots vazios para a hash */
+static void alocarSlots(HashTable *ht, size_t capacidade) {
+    ht->capacidade = potenciaDe2(capacidade);
+    ht->qtd = 0;
+    ht->slots = (HashEntry*) calloc(ht->capacidade, sizeof(HashEntry));
+    ESTAT_ALOC(EST_HASH, ht->capacidade * sizeof(HashEntry));
+    if (!ht->slots) { fprintf(stderr, "Erro hash malloc\n"); exit(EXIT_FAILURE); }
+}
+
+/* Inicializa a tabela hash com a capacidade pedida (todos os slots vazios);
+   textos de pistas e suspeitos são internados no pool 'ps' */
+void inicializarHashCapacidade(HashTable *ht, PoolStrings *ps, size_t capacidade) {
+    alocarSlots(ht, capacidade);
+    ht->strings = ps;
+    memset(&ht->suspeitos, 0, sizeof ht->suspeitos);
+    ht->listas = NULL;
+    ht->usadoListas = ht->capListas = ht->lixoListas = ht->qtdExtras = 0;
+}
+
+/* Inicializa a tabela hash com a capacidade padrão */
+void inicializarHash(HashTable *ht, PoolStrings *ps) {
+    inicializarHashCapacidade(ht, ps, HASH_SIZE);
+}
+
+/* colocarEntrada: posiciona entrada cuja chave não está na tabela (Robin Hood:
+   quem está mais longe do slot ideal toma o lugar de quem está mais perto) */
+static void colocarEntrada(HashTable *ht, HashEntry e) {
+    size_t mask = ht->capacidade - 1;
+    size_t i = e.hash & mask;
+    e.dist = 1;
+    while (1) {
+        HashEntry *slot = &ht->slots[i];
+        if (slot->dist == 0) {
+            *slot = e;
+            ht->qtd++;
+            return;
+        }
+        if (slot->dist < e.dist) {
+            HashEntry tmp = *slot;
+            *slot = e;
+            e = tmp;
+        }
+        i = (i + 1) & mask;
+        e.dist++;
+    }
+}
+
+/* redimensionarHash: realoca o bloco de slots e reposiciona todas as entradas */
+static void redimensionarHash(HashTable *ht, size_t novaCapacidade) {
+    HashEntry *antigos = ht->slots;
+    size_t capAntiga = ht->capacidade;
+    alocarSlots(ht, novaCapacidade);
+    for (size_t i = 0; i < capAntiga; ++i)
+        if (antigos[i].dist != 0) colocarEntrada(ht, antigos[i]);
+    free(antigos);
+}
+
+/* reservarHash: garante espaço para qtdEsperada entradas sem redimensionar */
+void reservarHash(HashTable *ht, size_t qtdEsperada) {
+    size_t necessaria = (size_t)(qtdEsperada / HASH_CARGA_MAX) + 1;
+    if (necessaria > ht->capacidade) redimensionarHash(ht, necessaria);
+}
+
+/* buscarEntrada: retorna o slot com a chave ou NULL; para cedo quando encontra
+   um slot vazio ou uma entrada mais próxima do ideal do que a sondagem atual */
+static HashEntry* buscarEntrada(const HashTable *ht, const char *pista, unsigned int h) {
+    size_t mask = ht->capacidade - 1;
+    size_t i = h & mask;
+    for (unsigned int d = 1; ; ++d) {
+        HashEntry *slot = &ht->slots[i];
+        if (slot->dist < d) { ESTAT(registrarSondagem(d)); return NULL; } /* inclui slot vazio (dist 0) */
+        if (slot->hash == h && strcmp(texto(ht->strings, slot->pista), pista) == 0) {
+            ESTAT(registrarSondagem(d));
+            return slot;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+/* buscarEntradaStr: como buscarEntrada, mas a chave já está internada (compara StrId) */
+static HashEntry* buscarEntradaStr(const HashTable *ht, StrId pista, unsigned int h) {
+    size_t mask = ht->capacidade - 1;
+    size_t i = h & mask;
+    for (unsigned int d = 1; ; ++d) {
+        HashEntry *slot = &ht->slots[i];
+        if (slot->dist < d) { ESTAT(registrarSondagem(d)); return NULL; }
+        if (slot->pista == pista) { ESTAT(registrarSondagem(d)); return slot; }
+        i = (i + 1) & mask;
+    }
+}
+
+/* -------- listas de suspeitos por pista (varint, diferenças em ordem crescente) -------- */
+
+/* Percurso de uma lista de suspeitos (ou do suspeito único da entrada) */
+typedef struct {
+    const unsigned char *p;     /* próximo varint; NULL para suspeito único */
+    uint32_t restantes;
+    int atual;                  /* último id lido (base das diferenças) */
+} CursorSuspeitos;
+
+static size_t gravarVarint(unsigned char *d, uint32_t v) {
+    size_t n = 0;
+    for (; v >= 0x80; v >>= 7) d[n++] = (unsigned char) (v | 0x80);
+    d[n++] = (unsigned char) v;
+    return n;
+}
+
+static uint32_t lerVarint(const unsigned char **p) {
+    const unsigned char *q = *p;
+    uint32_t v = 0;
+    for (unsigned desl = 0; ; desl += 7) {
+        unsigned char b = *q++;
+        v |= (uint32_t) (b & 0x7F) << desl;
+        if (!(b & 0x80)) break;
+    }
+    *p = q;
+    return v;
+}
+
+/* abrirSuspeitos: posiciona o cursor no primeiro suspeito da entrada; devolve o principal */
+static int abrirSuspeitos(const HashTable *ht, const HashEntry *e, CursorSuspeitos *c) {
+    if (e->suspeito >= 0) {
+        c->p = NULL;
+        c->restantes = 1;
+        c->atual = e->suspeito;
+        return e->suspeito;
+    }
+    const unsigned char *p = ht->listas + (size_t) (-(e->suspeito + 1));
+    int principal = (int) lerVarint(&p);
+    c->restantes = lerVarint(&p);
+    c->p = p;
+    c->atual = 0;
+    return principal;
+}
+
+/* proximoSuspeito: próximo id da lista (ordem crescente), -1 no fim */
+static int proximoSuspeito(CursorSuspeitos *c) {
+    if (c->restantes == 0) return -1;
+    c->restantes--;
+    if (c->p) c->atual += (int) lerVarint(&c->p);
+    return c->atual;
+}
+
+/* principalDaEntrada: suspeito da associação mais recente */
+static int principalDaEntrada(const HashTable *ht, const HashEntry *e) {
+    CursorSuspeitos c;
+    return abrirSuspeitos(ht, e, &c);
+}
+
+/* compactarListas: copia só as listas em uso para um bloco novo */
+static void compactarListas(HashTable *ht) {
+    size_t cap = ht->usadoListas - ht->lixoListas;
+    unsigned char *novo = (unsigned char*) malloc(cap ? cap : 1);
+    ESTAT_ALOC(EST_HASH, cap);
+    if (!novo) { fprintf(stderr, "Erro de memória (listas de suspeitos)\n"); exit(EXIT_FAILURE); }
+    size_t usado = 0;
+    for (size_t i = 0; i < ht->capacidade; ++i) {
+        HashEntry *e = &ht->slots[i];
+        if (e->dist == 0 || e->suspeito >= 0) continue;
+        CursorSuspeitos c;
+        const unsigned char *ini = ht->listas + (size_t) (-(e->suspeito + 1));
+        abrirSuspeitos(ht, e, &c);
+        while (proximoSuspeito(&c) >= 0) {}
+        size_t tam = (size_t) (c.p - ini);
+        memcpy(novo + usado, ini, tam);
+        e->suspeito = -(int) usado - 1;
+        usado += tam;
+    }
+    free(ht->listas);
+    ht->listas = novo;
+    ht->usadoListas = ht->capListas = usado;
+    ht->lixoListas = 0;
+}
+
+/* gravarLista: codifica (principal, ids[0..qtd)) no fim do bloco de listas e
+   aponta a entrada para ela; 'tamAntigo' bytes da lista anterior viram lixo */
+static void gravarLista(HashTable *ht, HashEntry *e, int principal, const int *ids, size_t qtd, size_t tamAntigo) {
+    size_t max = 5 * (qtd + 2);
+    if (ht->usadoListas + max > (size_t) INT32_MAX) {
+        fprintf(stderr, "Erro: listas de suspeitos excedem 2 GiB\n");
+        exit(EXIT_FAILURE);
+    }
+    if (ht->usadoListas + max > ht->capListas) {
+        size_t nova = ht->capListas ? ht->capListas * 2 : 4096;
+        while (nova < ht->usadoListas + max) nova *= 2;
+        unsigned char *d = (unsigned char*) realloc(ht->listas, nova);
+        ESTAT_ALOC(EST_HASH, nova);
+        if (!d) { fprintf(stderr, "Erro de memória (listas de suspeitos)\n"); exit(EXIT_FAILURE); }
+        ht->listas = d;
+        ht->capListas = nova;
+    }
+    size_t off = ht->usadoListas;
+    unsigned char *d = ht->listas + off;
+    size_t n = gravarVarint(d, (uint32_t) principal);
+    n += gravarVarint(d + n, (uint32_t) qtd);
+    for (size_t k = 0; k < qtd; ++k) n += gravarVarint(d + n, (uint32_t) (ids[k] - (k ? ids[k - 1] : 0)));
+    ht->usadoListas += n;
+    ht->lixoListas += tamAntigo;
+    e->suspeito = -(int) off - 1;
+}
+
+/* associarSuspeito: inclui 'id' na lista da entrada (conjunto: repetição não
+   duplica); com 'principal', ele passa a ser o suspeito principal */
+static void associarSuspeito(HashTable *ht, HashEntry *e, int id, int principal) {
+    if (e->suspeito >= 0) {
+        if (e->suspeito == id) return;
+        int ids[2] = { e->suspeito < id ? e->suspeito : id, e->suspeito < id ? id : e->suspeito };
+        gravarLista(ht, e, principal ? id : e->suspeito, ids, 2, 0);
+        ht->qtdExtras++;
+        return;
+    }
+    CursorSuspeitos c;
+    const unsigned char *ini = ht->listas + (size_t) (-(e->suspeito + 1));
+    int atual = abrirSuspeitos(ht, e, &c);
+    size_t qtd = c.restantes;
+    int pilha[64];
+    int *ids = qtd + 1 <= 64 ? pilha : (int*) malloc((qtd + 1) * sizeof(int));
+    if (!ids) { fprintf(stderr, "Erro de memória (listas de suspeitos)\n"); exit(EXIT_FAILURE); }
+    size_t pos = 0;
+    for (size_t k = 0; k < qtd; ++k) {
+        ids[k] = proximoSuspeito(&c);
+        if (ids[k] < id) pos = k + 1;
+    }
+    size_t tamAntigo = (size_t) (c.p - ini);
+    if (pos < qtd && ids[pos] == id) {
+        if (principal && atual != id) gravarLista(ht, e, id, ids, qtd, tamAntigo);
+    } else {
+        memmove(ids + pos + 1, ids + pos, (qtd - pos) * sizeof(int));
+        ids[pos] = id;
+        gravarLista(ht, e, principal ? id : atual, ids, qtd + 1, tamAntigo);
+        ht->qtdExtras++;
+    }
+    if (ids != pilha) free(ids);
+    if (ht->lixoListas > 4096 && ht->lixoListas > ht->usadoListas / 2) compactarListas(ht);
+}
+
+/* suspeitosDaPista: ids (em ordem crescente) dos suspeitos da pista; grava até
+   'max' em 'ids' e devolve o total (0 se a pista não tem associação) */
+size_t suspeitosDaPista(const HashTable *ht, StrId pista, int *ids, size_t max) {
+    if (pista == 0) return 0;
+    const HashEntry *e = buscarEntradaStr(ht, pista, hashChave(texto(ht->strings, pista)));
+    if (!e) return 0;
+    CursorSuspeitos c;
+    abrirSuspeitos(ht, e, &c);
+    size_t total = c.restantes, k = 0;
+    for (int s; k < max && (s = proximoSuspeito(&c)) >= 0; ++k) ids[k] = s;
+    return total;
+}
+
+/* Pista a intersectar: entrada na hash e tamanho da lista */
+typedef struct {
+    const HashEntry *e;
+    uint32_t qtd;
+} ListaIntersecao;
+
+static int compararListas(const void *a, const void *b) {
+    uint32_t x = ((const ListaIntersecao*) a)->qtd, y = ((const ListaIntersecao*) b)->qtd;
+    return (x > y) - (x < y);
+}
+
+/* intersectarSuspeitos: suspeitos presentes nas listas de todas as pistas
+   dadas (pistas sem associação não restringem; *usadas conta as que
+   restringiram). Começa pela lista mais curta e filtra os candidatos contra
+   as demais em ordem crescente de tamanho, por intercalação (as listas estão
+   ordenadas): O(soma dos tamanhos lidos). 'saida' precisa de espaço para a
+   menor lista; devolve quantos candidatos restaram, em ordem crescente. */
+size_t intersectarSuspeitos(const HashTable *ht, const StrId *pistas, size_t qtd, int *saida, size_t *usadas) {
+    ListaIntersecao pilha[16];
+    ListaIntersecao *listas = qtd <= 16 ? pilha : (ListaIntersecao*) malloc(qtd * sizeof(ListaIntersecao));
+    if (!listas) { fprintf(stderr, "Erro de memória (interseção)\n"); exit(EXIT_FAILURE); }
+    size_t n = 0;
+    for (size_t k = 0; k < qtd; ++k) {
+        if (pistas[k] == 0) continue;
+        const HashEntry *e = buscarEntradaStr(ht, pistas[k], hashChave(texto(ht->strings, pistas[k])));
+        if (!e) continue;
+        CursorSuspeitos c;
+        abrirSuspeitos(ht, e, &c);
+        listas[n].e = e;
+        listas[n++].qtd = c.restantes;
+    }
+    *usadas = n;
+    if (n == 0) { if (listas != pilha) free(listas); return 0; }
+    qsort(listas, n, sizeof *listas, compararListas);
+
+    CursorSuspeitos c;
+    abrirSuspeitos(ht, listas[0].e, &c);
+    size_t cand = 0;
+    for (int s; (s = proximoSuspeito(&c)) >= 0; ) saida[cand++] = s;
+    for (size_t k = 1; k < n && cand > 0; ++k) {
+        abrirSuspeitos(ht, listas[k].e, &c);
+        size_t mantidos = 0;
+        int s = proximoSuspeito(&c);
+        for (size_t j = 0; j < cand && s >= 0; ++j) {
+            while (s >= 0 && s < saida[j]) s = proximoSuspeito(&c);
+            if (s == saida[j]) saida[mantidos++] = saida[j];
+        }
+        cand = mantidos;
+    }
+    if (listas != pilha) free(listas);
+    return cand;
+}
+
+/* inserirNaHash: associa pista->suspeito; se a pista já existe, o suspeito
+   entra na lista dela e passa a ser o principal. Pista ou suspeito vazio é ignorado. */
+void inserirNaHash(HashTable *ht, const char *pista, const char *suspeito) {
+    if (!pista || !suspeito || pista[0] == '\0' || suspeito[0] == '\0') return;
+    StrId p = internarString(ht->strings, pista);
+    inserirNaHashStr(ht, p, internarString(ht->strings, suspeito));
+}
+
+/* inserirNaHashStr: como inserirNaHash, com textos já presentes no pool da hash */
+void inserirNaHashStr(HashTable *ht, StrId pista, StrId suspeito) {
+    if (pista == 0 || suspeito == 0) return; /* StrId 0 é o texto vazio: não vira suspeito */
+    HashEntry entry;
+    memset(&entry, 0, sizeof entry);
+    entry.pista = pista;
+    entry.suspeito = internarSimbolo(&ht->suspeitos, suspeito);
+    entry.hash = hashChave(texto(ht->strings, pista));
+
+    HashEntry *existente = buscarEntradaStr(ht, entry.pista, entry.hash);
+    if (existente) {
+        associarSuspeito(ht, existente, entry.suspeito, 1);
+        return;
+    }
+    if (ht->qtd + 1 > ht->capacidade * HASH_CARGA_MAX)
+        redimensionarHash(ht, ht->capacidade * 2);
+    colocarEntrada(ht, entry);
+}
+
+/* acrescentarSuspeitoStr: como inserirNaHashStr, mas sem trocar o suspeito
+   principal de uma pista já associada (usado ao recarregar as listas) */
+void acrescentarSuspeitoStr(HashTable *ht, StrId pista, StrId suspeito) {
+    if (pista == 0 || suspeito == 0) return;
+    HashEntry *existente = buscarEntradaStr(ht, pista, hashChave(texto(ht->strings, pista)));
+    if (!existente) { inserirNaHashStr(ht, pista, suspeito); return; }
+    associarSuspeito(ht, existente, internarSimbolo(&ht->suspeitos, suspeito), 0);
+}
+
+/* encontrarSuspeitoId: id do suspeito associado à pista, ou -1 */
+int encontrarSuspeitoId(const HashTable *ht, const char *pista) {
+    if (!pista) return -1;
+    HashEntry *e = buscarEntrada(ht, pista, hashChave(pista));
+    return e ? principalDaEntrada(ht, e) : -1;
+}
+
+/* encontrarSuspeitoIdStr: como encontrarSuspeitoId, para pista já internada */
+int encontrarSuspeitoIdStr(const HashTable *ht, StrId pista) {
+    if (pista == 0) return -1;
+    HashEntry *e = buscarEntradaStr(ht, pista, hashChave(texto(ht->strings, pista)));
+    return e ? principalDaEntrada(ht, e) : -1;
+}
+
+/* encontrarSuspeito: retorna ponteiro interno para nome do suspeito ou NULL.
+   O ponteiro só é válido até a próxima internação no pool. */
+const char* encontrarSuspeito(HashTable *ht, const char *pista) {
+    return nomeSuspeito(ht, encontrarSuspeitoId(ht, pista));
+}
+
+/* estatisticasHash: fator de carga e distribuição do comprimento de sondagem */
+void estatisticasHash(const HashTable *ht, EstatisticasHash *est) {
+    memset(est, 0, sizeof *est);
+    est->capacidade = ht->capacidade;
+    est->qtd = ht->qtd;
+    est->fatorCarga = (double) ht->qtd / ht->capacidade;
+    size_t soma = 0;
+    for (size_t i = 0; i < ht->capacidade; ++i) {
+        unsigned int d = ht->slots[i].dist;
+        if (d == 0) continue;
+        soma += d;
+        if (d > est->sondagemMax) est->sondagemMax = d;
+        est->histograma[d <= HASH_HIST_MAX ? d - 1 : HASH_HIST_MAX - 1]++;
+    }
+    est->sondagemMedia = ht->qtd ? (double) soma / ht->qtd : 0.0;
+}
+
+/* imprimirEstatisticasHash: resumo legível das estatísticas da hash */
+void imprimirEstatisticasHash(const HashTable *ht) {
+    EstatisticasHash est;
+    estatisticasHash(ht, &est);
+    printf("Hash: %zu entradas / %zu slots (carga %.2f), sondagem média %.2f, máxima %u\n",
+           est.qtd, est.capacidade, est.fatorCarga, est.sondagemMedia, est.sondagemMax);
+    printf("Histograma de sondagens:");
+    for (int k = 0; k < HASH_HIST_MAX; ++k)
+        if (est.histograma[k]) printf(" %d%s:%zu", k + 1, k == HASH_HIST_MAX - 1 ? "+" : "", est.histograma[k]);
+    printf("\n");
+}
+
+/* slotSimbolo: posição inicial no índice (StrId espalhado por multiplicação) */
+static size_t slotSimbolo(const TabelaSimbolos *ts, StrId nome) {
+    return (size_t) (nome * 2654435761u) & (ts->capIndice - 1);
+}
+
+/* internarSimbolo: devolve o id do nome, criando um novo id se ainda não existir */
+int internarSimbolo(TabelaSimbolos *ts, StrId nome) {
+    int id = buscarSimbolo(ts, nome);
+    if (id >= 0) return id;
+
+    if (ts->qtd == ts->capNomes) {
+        size_t nova = ts->capNomes ? ts->capNomes * 2 : 16;
+        StrId *nomes = (StrId*) realloc(ts->nomes, nova * sizeof *nomes);
+        ESTAT_ALOC(EST_SIMBOLOS, nova * sizeof *nomes);
+        if (!nomes) { fprintf(stderr, "Erro de memória (símbolos)\n"); exit(EXIT_FAILURE); }
+        ts->nomes = nomes;
+        ts->capNomes = nova;
+    }
+    /* índice mantido com carga <= 1/2; ao crescer, reinsere todos os ids */
+    if ((ts->qtd + 1) * 2 > ts->capIndice) {
+        free(ts->indice);
+        ts->capIndice = potenciaDe2((ts->qtd + 1) * 4);
+        ts->indice = (int*) calloc(ts->capIndice, sizeof(int));
+        ESTAT_ALOC(EST_SIMBOLOS, ts->capIndice * sizeof(int));
+        if (!ts->indice) { fprintf(stderr, "Erro de memória (símbolos)\n"); exit(EXIT_FAILURE); }
+        for (size_t k = 0; k < ts->qtd; ++k) {
+            size_t i = slotSimbolo(ts, ts->nomes[k]);
+            while (ts->indice[i]) i = (i + 1) & (ts->capIndice - 1);
+            ts->indice[i] = (int) k + 1;
+        }
+    }
+    id = (int) ts->qtd++;
+    ts->nomes[id] = nome;
+    size_t i = slotSimbolo(ts, nome);
+    while (ts->indice[i]) i = (i + 1) & (ts->capIndice - 1);
+    ts->indice[i] = id + 1;
+    return id;
+}
+
+/* buscarSimbolo: id do nome ou -1 (sondagem linear no índice) */
+int buscarSimbolo(const TabelaSimbolos *ts, StrId nome) {
+    if (nome == 0 || ts->capIndice == 0) return -1;
+    size_t i = slotSimbolo(ts, nome);
+    while (ts->indice[i]) {
+        int id = ts->indice[i] - 1;
+        if (ts->nomes[id] == nome) return id;
+        i = (i + 1) & (ts->capIndice - 1);
+    }
+    return -1;
+}
+
+/* simboloStr: StrId do nome do id, ou 0 para id inválido */
+StrId simboloStr(const TabelaSimbolos *ts, int id) {
+    if (id < 0 || (size_t) id >= ts->qtd) return 0;
+    return ts->nomes[id];
+}
+
+/* liberarSimbolos: libera vetores da tabela */
+void liberarSimbolos(TabelaSimbolos *ts) {
+    free(ts->nomes);
+    free(ts->indice);
+    memset(ts, 0, sizeof *ts);
+}
+
+/* nomeSuspeito: texto do nome do id, ou NULL para id inválido */
+const char* nomeSuspeito(const HashTable *ht, int id) {
+    StrId nome = simboloStr(&ht->suspeitos, id);
+    return nome ? texto(ht->strings, nome) : NULL;
+}
+
+/* inicializarInvestigacao: investigação vazia */
+void inicializarInvestigacao(Investigacao *inv) {
+    inicializarArena(&inv->arena);
+    inv->raizPistas = NULL;
+    inv->pistasPorSuspeito = NULL;
+    inv->ranking = inv->posRanking = NULL;
+    inv->qtdRanking = 0;
+    inv->capSuspeitos = 0;
+    inv->pistasDistintas = 0;
+    inv->maisCitado = -1;
+}
+
+/* reiniciarInvestigacao: esvazia a investigação reaproveitando arena e contadores */
+void reiniciarInvestigacao(Investigacao *inv) {
+    arenaReiniciar(&inv->arena);
+    inv->raizPistas = NULL;
+    /* só os suspeitos citados têm contagem diferente de zero */
+    for (size_t k = 0; k < inv->qtdRanking; ++k) inv->pistasPorSuspeito[inv->ranking[k]] = 0;
+    inv->qtdRanking = 0;
+    inv->pistasDistintas = 0;
+    inv->maisCitado = -1;
+}
+
+/* crescerSuspeitos: amplia contadores e ranking para caber o id (contagens novas = 0) */
+static void crescerSuspeitos(Investigacao *inv, int id) {
+    size_t nova = inv->capSuspeitos ? inv->capSuspeitos : 16;
+    while (nova <= (size_t) id) nova *= 2;
+    int *cont = (int*) realloc(inv->pistasPorSuspeito, nova * sizeof(int));
+    if (cont) inv->pistasPorSuspeito = cont;
+    int *rank = (int*) realloc(inv->ranking, nova * sizeof(int));
+    if (rank) inv->ranking = rank;
+    int *pos = (int*) realloc(inv->posRanking, nova * sizeof(int));
+    if (pos) inv->posRanking = pos;
+    ESTAT_ALOC(EST_INVESTIGACAO, 3 * nova * sizeof(int));
+    if (!cont || !rank || !pos) { fprintf(stderr, "Erro de memória (investigação)\n"); exit(EXIT_FAILURE); }
+    memset(cont + inv->capSuspeitos, 0, (nova - inv->capSuspeitos) * sizeof(int));
+    inv->capSuspeitos = nova;
+}
+
+/* subirNoRanking: mais uma coleta para 'id'. Como a contagem cresce de 1 em 1,
+   basta trocar o id com o primeiro do bloco da sua contagem antiga (achado
+   por busca binária no ranking): O(log suspeitos citados) por coleta. O id
+   entra no fim do bloco novo, mas o primeiro do bloco antigo vai para a
+   posição que ele deixou: a ordem dentro de um empate não é preservada. */
+static void subirNoRanking(Investigacao *inv, int id) {
+    int *cont = inv->pistasPorSuspeito;
+    if (cont[id] == INT_MAX) return; /* contagem saturada */
+    int c = cont[id]++;
+    if (c == 0) { /* primeira citação: contagem 1 é a menor, entra no fim */
+        inv->posRanking[id] = (int) inv->qtdRanking;
+        inv->ranking[inv->qtdRanking++] = id;
+    } else {
+        size_t ini = 0, fim = (size_t) inv->posRanking[id];
+        while (ini < fim) { /* primeira posição com contagem <= c (o próprio id tem c+1 agora) */
+            size_t meio = ini + (fim - ini) / 2;
+            if (cont[inv->ranking[meio]] > c) ini = meio + 1; else fim = meio;
+        }
+        int outro = inv->ranking[ini], p = inv->posRanking[id];
+        inv->ranking[ini] = id;
+        inv->ranking[p] = outro;
+        inv->posRanking[id] = (int) ini;
+        inv->posRanking[outro] = p;
+    }
+    inv->maisCitado = inv->ranking[0];
+}
+
+/* somarNoRanking: 'coletas' (> 0) coletas de uma vez para 'id', contagem
+   saturada em INT_MAX. O id sobe uma vez só: busca binária da primeira
+   posição com contagem menor que a nova e deslocamento do bloco entre ela e
+   a posição antiga, O(log citados + bloco deslocado), sem depender de 'coletas'. */
+static void somarNoRanking(Investigacao *inv, int id, int coletas) {
+    int *cont = inv->pistasPorSuspeito;
+    if (coletas == 1) { subirNoRanking(inv, id); return; }
+    if (cont[id] == 0) {
+        inv->posRanking[id] = (int) inv->qtdRanking;
+        inv->ranking[inv->qtdRanking++] = id;
+    }
+    int nova = cont[id] > INT_MAX - coletas ? INT_MAX : cont[id] + coletas;
+    cont[id] = nova;
+    size_t ini = 0, fim = (size_t) inv->posRanking[id];
+    while (ini < fim) {
+        size_t meio = ini + (fim - ini) / 2;
+        if (cont[inv->ranking[meio]] >= nova) ini = meio + 1; else fim = meio;
+    }
+    size_t p = (size_t) inv->posRanking[id];
+    memmove(inv->ranking + ini + 1, inv->ranking + ini, (p - ini) * sizeof(int));
+    for (size_t k = ini + 1; k <= p; ++k) inv->posRanking[inv->ranking[k]] = (int) k;
+    inv->ranking[ini] = id;
+    inv->posRanking[id] = (int) ini;
+    inv->maisCitado = inv->ranking[0];
+}
+
+/* suspeitosEmDestaque: aponta 'ids' para os até k suspeitos mais citados; devolve quantos.
+   Num empate que atravessa a posição k, quais dos empatados entram não é definido. */
+size_t suspeitosEmDestaque(const Investigacao *inv, size_t k, const int **ids) {
+    *ids = inv->ranking;
+    return k < inv->qtdRanking ? k : inv->qtdRanking;
+}
+
+/* coletarPista: registra a pista na BST (com o suspeito principal em cache) e
+   atualiza a contagem de cada suspeito da lista dela; retorna o nó da pista
+   (NULL para pista 0, que não é coletada). Uma descida só na BST.
+   Associações alteradas na hash depois da coleta não são refletidas. */
+BSTNode* coletarPista(Investigacao *inv, const HashTable *ht, StrId pista) {
+    if (pista == 0) return NULL;
+    const HashEntry *e = buscarEntradaStr(ht, pista, hashChave(texto(ht->strings, pista)));
+    CursorSuspeitos c;
+    int id = e ? abrirSuspeitos(ht, e, &c) : -1;
+    BSTNode *n;
+    inv->raizPistas = inserirPista(&inv->arena, ht->strings, inv->raizPistas, pista, id, &n);
+    ESTAT(estatLocal.alturaMaxBST < (uint64_t) inv->raizPistas->altura
+          ? (void) (estatLocal.alturaMaxBST = inv->raizPistas->altura) : (void) 0);
+    for (int s; e && (s = proximoSuspeito(&c)) >= 0; ) {
+        if ((size_t) s >= inv->capSuspeitos) crescerSuspeitos(inv, s);
+        subirNoRanking(inv, s);
+    }
+    if (n->contador == 1) inv->pistasDistintas++; /* nó acabou de ser criado */
+    return n;
+}
+
+/* -------- carga em lote: ordena, junta repetidas e monta a árvore balanceada -------- */
+
+/* Chave de ordenação de um lote: os 8 primeiros bytes do texto, em ordem
+   big-endian, decidem a maior parte das comparações sem ir ao pool */
+typedef struct {
+    uint64_t prefixo;
+    StrId pista;
+    int contador;
+} ChaveLote;
+
+/* prefixoTexto: 8 primeiros bytes como inteiro (zeros depois do terminador),
+   de modo que a ordem dos inteiros é a do strcmp */
+static uint64_t prefixoTexto(const char *t) {
+    uint64_t v = 0;
+    for (int k = 0; k < 8; ++k) {
+        v <<= 8;
+        if (*t) v |= (unsigned char) *t++;
+    }
+    return v;
+}
+
+static int compararChaves(const ChaveLote *a, const ChaveLote *b, const PoolStrings *ps) {
+    if (a->prefixo != b->prefixo) return a->prefixo < b->prefixo ? -1 : 1;
+    if ((a->prefixo & 0xFF) == 0 || a->pista == b->pista) return 0; /* textos acabam no prefixo */
+    return strcmp(texto(ps, a->pista) + 8, texto(ps, b->pista) + 8);
+}
+
+/* intercalarLote: junta duas faixas ordenadas em 'dst' (estável) */
+static void intercalarLote(const ChaveLote *a, size_t na, const ChaveLote *b, size_t nb,
+                           ChaveLote *dst, const PoolStrings *ps) {
+    size_t i = 0, j = 0, k = 0;
+    while (i < na && j < nb) dst[k++] = compararChaves(&b[j], &a[i], ps) < 0 ? b[j++] : a[i++];
+    while (i < na) dst[k++] = a[i++];
+    while (j < nb) dst[k++] = b[j++];
+}
+
+/* ordenarLote: inserção nas faixas curtas, mergesort com buffer acima disso */
+static void ordenarLote(ChaveLote *v, ChaveLote *tmp, size_t n, const PoolStrings *ps) {
+    if (n <= 16) {
+        for (size_t i = 1; i < n; ++i) {
+            ChaveLote x = v[i];
+            size_t j = i;
+            for (; j > 0 && compararChaves(&v[j - 1], &x, ps) > 0; --j) v[j] = v[j - 1];
+            v[j] = x;
+        }
+        return;
+    }
+    size_t meio = n / 2;
+    ordenarLote(v, tmp, meio, ps);
+    ordenarLote(v + meio, tmp, n - meio, ps);
+    intercalarLote(v, meio, v + meio, n - meio, tmp, ps);
+    memcpy(v, tmp, n * sizeof(ChaveLote));
+}
+
+/* Fatia de uma ordenação de lote em paralelo */
+typedef struct {
+    const PoolStrings *ps;
+    ChaveLote *origem, *destino;
+    size_t ini, meio, fim;      /* ordenar: [ini, fim); intercalar: [ini, meio) + [meio, fim) */
+    int intercalar;
+} TrabalhoLote;
+
+static void* executarTrabalhoLote(void *arg) {
+    TrabalhoLote *t = (TrabalhoLote*) arg;
+    if (!t->intercalar)
+        ordenarLote(t->origem + t->ini, t->destino + t->ini, t->fim - t->ini, t->ps);
+    else
+        intercalarLote(t->origem + t->ini, t->meio - t->ini, t->origem + t->meio, t->fim - t->meio,
+                       t->destino + t->ini, t->ps);
+    return NULL;
+}
+
+/* executarLoteEmParalelo: uma thread por fatia; fatia cuja thread não pôde
+   ser criada é executada aqui mesmo */
+static void executarLoteEmParalelo(TrabalhoLote *trab, unsigned n) {
+    pthread_t ids[SIM_THREADS_MAX];
+    int criada[SIM_THREADS_MAX];
+    for (unsigned i = 0; i < n; ++i)
+        criada[i] = i > 0 && pthread_create(&ids[i], NULL, executarTrabalhoLote, &trab[i]) == 0;
+    for (unsigned i = 0; i < n; ++i)
+        if (!criada[i]) executarTrabalhoLote(&trab[i]);
+    for (unsigned i = 0; i < n; ++i)
+        if (criada[i]) pthread_join(ids[i], NULL);
+}
+
+/* ordenarLoteEmParalelo: cada thread ordena uma fatia; depois rodadas de
+   intercalação aos pares (também em paralelo) alternando entre 'v' e 'tmp'.
+   Devolve o vetor que terminou com o resultado. */
+static ChaveLote* ordenarLoteEmParalelo(ChaveLote *v, ChaveLote *tmp, size_t n, unsigned nThreads,
+                                        const PoolStrings *ps) {
+    size_t limites[SIM_THREADS_MAX + 1];
+    TrabalhoLote trab[SIM_THREADS_MAX];
+    for (unsigned i = 0; i <= nThreads; ++i) limites[i] = n / nThreads * i + (n % nThreads) * i / nThreads;
+    for (unsigned i = 0; i < nThreads; ++i) {
+        TrabalhoLote t = { ps, v, tmp, limites[i], limites[i], limites[i + 1], 0 };
+        trab[i] = t;
+    }
+    executarLoteEmParalelo(trab, nThreads);
+
+    ChaveLote *origem = v, *destino = tmp;
+    for (unsigned largura = 1; largura < nThreads; largura *= 2) {
+        unsigned qtd = 0;
+        for (unsigned g = 0; g < nThreads; g += 2 * largura) {
+            unsigned m = g + largura < nThreads ? g + largura : nThreads;
+            unsigned f = g + 2 * largura < nThreads ? g + 2 * largura : nThreads;
+            TrabalhoLote t = { ps, origem, destino, limites[g], limites[m], limites[f], 1 };
+            trab[qtd++] = t;
+        }
+        executarLoteEmParalelo(trab, qtd);
+        ChaveLote *x = origem; origem = destino; destino = x;
+    }
+    return origem;
+}
+
+/* contarLote: soma 'coletas' coletas de uma pista em cada suspeito da lista dela;
+   devolve o suspeito principal (-1 se a pista não tem associação) */
+static int contarLote(Investigacao *inv, const HashTable *ht, StrId pista, int coletas) {
+    const HashEntry *e = buscarEntradaStr(ht, pista, hashChave(texto(ht->strings, pista)));
+    if (!e) return -1;
+    CursorSuspeitos c;
+    int principal = abrirSuspeitos(ht, e, &c);
+    for (int s; (s = proximoSuspeito(&c)) >= 0; ) {
+        if ((size_t) s >= inv->capSuspeitos) crescerSuspeitos(inv, s);
+        somarNoRanking(inv, s, coletas);
+    }
+    return principal;
+}
+
+/* coletarPistasEmLote: equivale a coletar cada pista do lote 'contador' vezes.
+   O lote é ordenado (em paralelo acima de LOTE_PARALELO_MIN pistas por
+   thread; 'threads' 0 = núcleos disponíveis), as repetidas viram uma entrada
+   com as coletas somadas, e o resultado é intercalado com as pistas já
+   coletadas num vetor contíguo da arena, do qual a AVL é montada pelo meio
+   em O(n). Cada entrada distinta atualiza cada suspeito seu uma vez
+   (somarNoRanking), qualquer que seja a soma das coletas; contagens saturam
+   em INT_MAX. Os nós antigos ficam na arena até o reinício. */
+size_t coletarPistasEmLote(Investigacao *inv, const HashTable *ht, const PistaLote *lote, size_t qtd,
+                           unsigned threads) {
+    const PoolStrings *ps = ht->strings;
+    ChaveLote *v = (ChaveLote*) malloc((qtd ? 2 * qtd : 1) * sizeof(ChaveLote));
+    if (!v) { fprintf(stderr, "Erro de memória (lote)\n"); exit(EXIT_FAILURE); }
+    ChaveLote *tmp = v + qtd;
+    size_t n = 0;
+    for (size_t k = 0; k < qtd; ++k) {
+        if (lote[k].pista == 0 || lote[k].contador <= 0) continue;
+        ChaveLote c = { prefixoTexto(texto(ps, lote[k].pista)), lote[k].pista, lote[k].contador };
+        v[n++] = c;
+    }
+
+    unsigned nThreads = threads;
+    if (nThreads == 0) {
+        long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+        nThreads = nucleos > 0 ? (unsigned) nucleos : 1;
+    }
+    if (nThreads > SIM_THREADS_MAX) nThreads = SIM_THREADS_MAX;
+    if (nThreads > n / LOTE_PARALELO_MIN) nThreads = (unsigned) (n / LOTE_PARALELO_MIN);
+    ChaveLote *ord = v;
+    if (nThreads > 1) ord = ordenarLoteEmParalelo(v, tmp, n, nThreads, ps);
+    else ordenarLote(v, tmp, n, ps);
+
+    size_t d = 0; /* repetidas: uma entrada, coletas somadas (saturando) */
+    for (size_t k = 0; k < n; ++k) {
+        if (d > 0 && compararChaves(&ord[d - 1], &ord[k], ps) == 0)
+            ord[d - 1].contador = ord[d - 1].contador > INT_MAX - ord[k].contador
+                                  ? INT_MAX : ord[d - 1].contador + ord[k].contador;
+        else
+            ord[d++] = ord[k];
+    }
+
+    /* pistas já coletadas, em ordem */
+    size_t e = inv->pistasDistintas, qtdAntigos = 0;
+    BSTNode **antigos = (BSTNode**) malloc((e ? e : 1) * sizeof(BSTNode*));
+    if (!antigos) { fprintf(stderr, "Erro de memória (lote)\n"); exit(EXIT_FAILURE); }
+    BSTNode *pilha[BST_ALTURA_MAX];
+    int topo = 0;
+    for (BSTNode *x = inv->raizPistas; x || topo > 0; x = x->dir) {
+        for (; x; x = x->esq) pilha[topo++] = x; /* altura limitada por BST_ALTURA_MAX na inserção */
+        x = pilha[--topo];
+        antigos[qtdAntigos++] = x;
+    }
+
+    BSTNode *nos = (BSTNode*) arenaAlocar(&inv->arena, (qtdAntigos + d ? qtdAntigos + d : 1) * sizeof(BSTNode));
+    size_t m = 0, i = 0, j = 0, novas = 0;
+    while (i < qtdAntigos || j < d) {
+        int cmp = i == qtdAntigos ? 1 : j == d ? -1
+                : antigos[i]->pista == ord[j].pista ? 0
+                : strcmp(texto(ps, antigos[i]->pista), texto(ps, ord[j].pista));
+        BSTNode *x = &nos[m++];
+        if (cmp <= 0) {
+            *x = *antigos[i++];
+            if (cmp == 0) {
+                x->contador = x->contador > INT_MAX - ord[j].contador ? INT_MAX : x->contador + ord[j].contador;
+                contarLote(inv, ht, ord[j].pista, ord[j].contador);
+                j++;
+            }
+        } else {
+            x->pista = ord[j].pista;
+            x->contador = ord[j].contador;
+            x->suspeito = contarLote(inv, ht, ord[j].pista, ord[j].contador);
+            j++;
+            novas++;
+        }
+    }
+    inv->raizPistas = montarBalanceada(nos, m);
+    inv->pistasDistintas = m;
+    free(antigos);
+    free(v);
+    return novas;
+}
+
+/* contadorPistasParaSuspeito: quantas coletas apontam para 'suspeito' (O(1) após a busca do id) */
+int contadorPistasParaSuspeito(const Investigacao *inv, const HashTable *ht, const char *suspeito) {
+    int id = buscarSimbolo(&ht->suspeitos, buscarString(ht->strings, suspeito));
+    if (id < 0 || (size_t) id >= inv->capSuspeitos) return 0;
+    return inv->pistasPorSuspeito[id];
+}
+
+/* liberarInvestigacao: libera BST (arena inteira) e contadores */
+void liberarInvestigacao(Investigacao *inv) {
+    liberarArena(&inv->arena);
+    free(inv->pistasPorSuspeito);
+    free(inv->ranking);
+    free(inv->posRanking);
+    inicializarInvestigacao(inv);
+}
+
+/* inicializarSaida: buffer vazio; o bloco só é obtido na primeira escrita */
+void inicializarSaida(Saida *out, FILE *destino, ModoSaida modo) {
+    out->dados = NULL;
+    out->usado = out->cap = 0;
+    out->destino = destino;
+    out->modo = modo;
+}
+
+/* saidaPrintf: acrescenta texto formatado ao buffer (cresce dobrando) */
+void saidaPrintf(Saida *out, const char *fmt, ...) {
+    if (out->modo == SAIDA_SILENCIOSA) return;
+    va_list args;
+    va_start(args, fmt);
+    if (out->modo == SAIDA_DIRETA) {
+        vfprintf(out->destino, fmt, args);
+        va_end(args);
+        return;
+    }
+    va_list copia;
+    va_copy(copia, args);
+    size_t livre = out->cap - out->usado;
+    int n = vsnprintf(out->dados ? out->dados + out->usado : NULL, livre, fmt, args);
+    va_end(args);
+    if (n < 0) { va_end(copia); return; }
+    if ((size_t) n >= livre) {
+        size_t nova = out->cap ? out->cap : SAIDA_INICIAL;
+        while (nova - out->usado <= (size_t) n) nova *= 2;
+        char *d = (char*) realloc(out->dados, nova);
+        if (!d) { fprintf(stderr, "Erro de memória (saída)\n"); exit(EXIT_FAILURE); }
+        out->dados = d;
+        out->cap = nova;
+        vsnprintf(out->dados + out->usado, out->cap - out->usado, fmt, copia);
+    }
+    va_end(copia);
+    out->usado += (size_t) n;
+    if (out->usado >= SAIDA_LIMITE) saidaDescarregar(out);
+}
+
+/* saidaDescarregar: grava o que estiver acumulado com uma única escrita.
+   Vai direto ao descritor: o buffer de linha do stdio (terminal) faria uma
+   escrita por linha. O que o stdio já tinha pendente sai antes. */
+void saidaDescarregar(Saida *out) {
+    if (out->modo == SAIDA_SILENCIOSA) return;
+    fflush(out->destino);
+    size_t feito = 0;
+    int fd = fileno(out->destino);
+    while (feito < out->usado) {
+        ssize_t n = write(fd, out->dados + feito, out->usado - feito);
+        if (n <= 0) break; /* erro de escrita: descarta, como o stdio faria */
+        feito += (size_t) n;
+    }
+    out->usado = 0;
+}
+
+/* liberarSaida: grava o restante e libera o buffer */
+void liberarSaida(Saida *out) {
+    saidaDescarregar(out);
+    free(out->dados);
+    inicializarSaida(out, out->destino, out->modo);
+}
+
+/* iniciarNavegacao: jogador no Hall (sala 0), sem histórico; o índice de
+   posições tem uma entrada por sala do mapa */
+void iniciarNavegacao(Navegacao *nav, const Mansao *m) {
+    nav->atual = 0;
+    nav->pilha = nav->frente = NULL;
+    nav->topo = nav->capPilha = nav->qtdFrente = nav->capFrente = 0;
+    nav->qtdSalas = m->qtd;
+    nav->posicao = (uint32_t*) calloc(m->qtd ? m->qtd : 1, sizeof(uint32_t));
+    if (!nav->posicao) { fprintf(stderr, "Erro de memória (histórico)\n"); exit(EXIT_FAILURE); }
+}
+
+/* reiniciarNavegacao: volta ao Hall reaproveitando os vetores (O(histórico), não O(salas)) */
+void reiniciarNavegacao(Navegacao *nav) {
+    for (size_t k = 0; k < nav->topo; ++k) nav->posicao[nav->pilha[k]] = 0;
+    nav->atual = 0;
+    nav->topo = nav->qtdFrente = 0;
+}
+
+/* crescerHistorico: dobra a capacidade de uma das pilhas (O(1) amortizado) */
+static uint32_t* crescerHistorico(uint32_t *v, size_t *cap) {
+    size_t nova = *cap ? *cap * 2 : HISTORICO_INICIAL;
+    uint32_t *d = (uint32_t*) realloc(v, nova * sizeof(uint32_t));
+    if (!d) { fprintf(stderr, "Erro de memória (histórico)\n"); exit(EXIT_FAILURE); }
+    *cap = nova;
+    return d;
+}
+
+/* empilharAtual: guarda a sala atual na pilha de 'voltar' */
+static void empilharAtual(Navegacao *nav) {
+    if (nav->topo == nav->capPilha) nav->pilha = crescerHistorico(nav->pilha, &nav->capPilha);
+    nav->pilha[nav->topo++] = nav->atual;
+    nav->posicao[nav->atual] = (uint32_t) nav->topo;
+}
+
+/* desempilhar: retira a sala mais recente da pilha de 'voltar' */
+static uint32_t desempilhar(Navegacao *nav) {
+    uint32_t sala = nav->pilha[--nav->topo];
+    nav->posicao[sala] = 0;
+    return sala;
+}
+
+/* guardarFrente: sala desfeita por 'voltar' fica disponível para 'avançar' */
+static void guardarFrente(Navegacao *nav, uint32_t sala) {
+    if (nav->qtdFrente == nav->capFrente) nav->frente = crescerHistorico(nav->frente, &nav->capFrente);
+    nav->frente[nav->qtdFrente++] = sala;
+}
+
+/* irPara: avança para 'destino' por um caminho novo; se o destino já está no
+   histórico, o ciclo é compactado (a pilha volta ao ponto em que ele estava) */
+static void irPara(Navegacao *nav, uint32_t destino) {
+    nav->qtdFrente = 0; /* caminho novo invalida o 'avançar' */
+    if (destino == nav->atual) return;
+    uint32_t pos = nav->posicao[destino];
+    if (pos) {
+        while (nav->topo >= pos) desempilhar(nav);
+    } else {
+        empilharAtual(nav);
+    }
+    nav->atual = destino;
+}
+
+/* moverJogador: aplica um comando (e, d, p, b, f, s; maiúsculas aceitas) */
+ResultadoMovimento moverJogador(const Mansao *m, Navegacao *nav, char comando) {
+    const Sala *atual = &m->salas[nav->atual];
+    switch (comando) {
+    case 'e': case 'E':
+    case 'd': case 'D': {
+        uint32_t destino = (comando == 'e' || comando == 'E') ? atual->esquerda : atual->direita;
+        if (destino == SALA_NENHUMA) return MOV_SEM_CAMINHO;
+        irPara(nav, destino);
+        return MOV_OK;
+    }
+    case 'p': case 'P': {
+        uint32_t destino = salaPai(m, nav->atual);
+        if (destino == SALA_NENHUMA) return MOV_SEM_CAMINHO;
+        irPara(nav, destino);
+        return MOV_OK;
+    }
+    case 'b': case 'B':
+        if (nav->topo == 0) return MOV_SEM_ANTERIOR;
+        guardarFrente(nav, nav->atual);
+        nav->atual = desempilhar(nav);
+        return MOV_OK;
+    case 'f': case 'F':
+        if (nav->qtdFrente == 0) return MOV_SEM_PROXIMA;
+        empilharAtual(nav);
+        nav->atual = nav->frente[--nav->qtdFrente];
+        return MOV_OK;
+    case 's': case 'S':
+        return MOV_SAIR;
+    default:
+        return MOV_INVALIDO;
+    }
+}
+
+/* saltarHistorico: volta direto à sala pilha[posicao] (0 = primeira do
+   histórico); as salas puladas podem ser refeitas com 'avançar' */
+ResultadoMovimento saltarHistorico(Navegacao *nav, size_t posicao) {
+    if (posicao >= nav->topo) return MOV_INVALIDO;
+    guardarFrente(nav, nav->atual);
+    while (nav->topo > posicao + 1) guardarFrente(nav, desempilhar(nav));
+    nav->atual = desempilhar(nav);
+    return MOV_OK;
+}
+
+/* irParaSala: leva o jogador direto a qualquer sala (busca por nome/índice);
+   entra no histórico como um movimento comum */
+ResultadoMovimento irParaSala(const Mansao *m, Navegacao *nav, uint32_t sala) {
+    if (sala >= m->qtd) return MOV_INVALIDO;
+    irPara(nav, sala);
+    return MOV_OK;
+}
+
+/* saidaExtra: k-ésima saída do grafo que não é esquerda, direita nem o pai
+   (as que a visão de árvore não mostra); SALA_NENHUMA se não existe */
+static uint32_t saidaExtra(const Mansao *m, uint32_t sala, size_t k) {
+    const Sala *s = &m->salas[sala];
+    uint32_t pai = salaPai(m, sala);
+    for (uint32_t i = m->inicioVizinhos[sala]; i < m->inicioVizinhos[sala + 1]; ++i) {
+        uint32_t v = m->vizinhos[i];
+        if (v == s->esquerda || v == s->direita || v == pai) continue;
+        if (k-- == 0) return v;
+    }
+    return SALA_NENHUMA;
+}
+
+/* passarPor: segue a saída extra de número 'saida' (como listada no menu) */
+ResultadoMovimento passarPor(const Mansao *m, Navegacao *nav, size_t saida) {
+    uint32_t destino = saidaExtra(m, nav->atual, saida);
+    if (destino == SALA_NENHUMA) return MOV_INVALIDO;
+    irPara(nav, destino);
+    return MOV_OK;
+}
+
+/* liberarNavegacao: libera pilhas e índice de posições */
+void liberarNavegacao(Navegacao *nav) {
+    free(nav->pilha);
+    free(nav->frente);
+    free(nav->posicao);
+    nav->pilha = nav->frente = nav->posicao = NULL;
+    nav->topo = nav->capPilha = nav->qtdFrente = nav->capFrente = 0;
+}
+
+/* iniciarPlanejador: vetores da busca dimensionados para o mapa (uma alocação por vetor) */
+void iniciarPlanejador(PlanejadorRota *pr, const Mansao *m) {
+    size_t n = (size_t) m->qtd + 1;
+    pr->fila = (uint32_t*) malloc(n * sizeof(uint32_t));
+    pr->anterior = (uint32_t*) malloc(n * sizeof(uint32_t));
+    pr->marca = (uint32_t*) calloc(n, sizeof(uint32_t));
+    pr->rota = (uint32_t*) malloc(n * sizeof(uint32_t));
+    if (!pr->fila || !pr->anterior || !pr->marca || !pr->rota) {
+        fprintf(stderr, "Erro de memória (planejador)\n");
+        exit(EXIT_FAILURE);
+    }
+    pr->geracao = 0;
+    pr->qtdSalas = m->qtd;
+}
+
+/* pistaPendente: a sala tem pista e ela ainda não foi coletada (em nenhuma sala) */
+static int pistaPendente(const Mansao *m, const Investigacao *inv, uint32_t sala) {
+    StrId p = m->salas[sala].pista;
+    return p != 0 && !buscarPistaNode(m->strings, inv->raizPistas, texto(m->strings, p));
+}
+
+/* planejarRotaPista: busca em largura a partir de 'origem'; a primeira sala
+   com pista pendente é a mais próxima em passos. Para sem explorar o resto
+   do mapa e devolve o destino; a rota fica em pr->rota[0..*passos]. */
+uint32_t planejarRotaPista(PlanejadorRota *pr, const Mansao *m, const Investigacao *inv,
+                           uint32_t origem, size_t *passos) {
+    *passos = 0;
+    if (origem >= pr->qtdSalas) return SALA_NENHUMA;
+    if (++pr->geracao == 0) { /* volta completa do contador: zera as marcas uma vez */
+        memset(pr->marca, 0, ((size_t) pr->qtdSalas + 1) * sizeof(uint32_t));
+        pr->geracao = 1;
+    }
+    uint32_t g = pr->geracao, destino = SALA_NENHUMA;
+    size_t ini = 0, fim = 0;
+    pr->fila[fim++] = origem;
+    pr->marca[origem] = g;
+    pr->anterior[origem] = SALA_NENHUMA;
+    while (ini < fim) {
+        uint32_t s = pr->fila[ini++];
+        if (pistaPendente(m, inv, s)) { destino = s; break; }
+        for (uint32_t k = m->inicioVizinhos[s]; k < m->inicioVizinhos[s + 1]; ++k) {
+            uint32_t v = m->vizinhos[k];
+            if (pr->marca[v] == g) continue;
+            pr->marca[v] = g;
+            pr->anterior[v] = s;
+            pr->fila[fim++] = v;
+        }
+    }
+    if (destino == SALA_NENHUMA) return SALA_NENHUMA;
+
+    size_t n = 0;
+    for (uint32_t s = destino; s != SALA_NENHUMA; s = pr->anterior[s]) pr->rota[n++] = s;
+    for (size_t a = 0, b = n - 1; a < b; ++a, --b) {
+        uint32_t t = pr->rota[a]; pr->rota[a] = pr->rota[b]; pr->rota[b] = t;
+    }
+    *passos = n - 1;
+    return destino;
+}
+
+/* liberarPlanejador: libera os vetores da busca */
+void liberarPlanejador(PlanejadorRota *pr) {
+    free(pr->fila);
+    free(pr->anterior);
+    free(pr->marca);
+    free(pr->rota);
+    memset(pr, 0, sizeof *pr);
+}
+
+/* visitarSala: coleta a pista da sala, se houver e ainda não coletada.
+   Retorna o nó da pista (NULL se a sala não tem pista); *nova indica se foi coletada agora. */
+BSTNode* visitarSala(const Mansao *m, Investigacao *inv, const HashTable *ht, uint32_t sala, int *nova) {
+    StrId pista = m->salas[sala].pista;
+    *nova = 0;
+    if (pista == 0) return NULL;
+    BSTNode *n = buscarPistaNode(ht->strings, inv->raizPistas, texto(ht->strings, pista));
+    if (n) return n; /* revisitar não incrementa a contagem */
+    *nova = 1;
+    return coletarPista(inv, ht, pista);
+}
+
+/* imprimirDemaisSuspeitos: ", nome" para cada suspeito da pista além do principal */
+static void imprimirDemaisSuspeitos(Saida *out, const HashTable *ht, StrId pista, int principal) {
+    const HashEntry *e = buscarEntradaStr(ht, pista, hashChave(texto(ht->strings, pista)));
+    if (!e || e->suspeito >= 0) return;
+    CursorSuspeitos c;
+    abrirSuspeitos(ht, e, &c);
+    for (int id; (id = proximoSuspeito(&c)) >= 0; )
+        if (id != principal) saidaPrintf(out, ", %s", nomeSuspeito(ht, id));
+}
+
+/* imprimirCompativeis: suspeitos presentes nas listas de todas as pistas coletadas */
+static void imprimirCompativeis(Saida *out, const Investigacao *inv, const HashTable *ht) {
+    size_t n = inv->pistasDistintas, usadas;
+    StrId *pistas = (StrId*) malloc((n ? n : 1) * sizeof(StrId));
+    int *ids = (int*) malloc((ht->suspeitos.qtd ? ht->suspeitos.qtd : 1) * sizeof(int));
+    if (!pistas || !ids) { fprintf(stderr, "Erro de memória (interseção)\n"); exit(EXIT_FAILURE); }
+    buscarPistasPorPrefixo(ht->strings, inv->raizPistas, "", pistas, n);
+    size_t qtd = intersectarSuspeitos(ht, pistas, n, ids, &usadas);
+    if (usadas == 0)
+        saidaPrintf(out, "Nenhuma pista coletada aponta para um suspeito.\n");
+    else if (qtd == 0)
+        saidaPrintf(out, "Nenhum suspeito é compatível com as %zu pista(s) associadas.\n", usadas);
+    else {
+        saidaPrintf(out, "Suspeitos compatíveis com as %zu pista(s) associadas:", usadas);
+        for (size_t k = 0; k < qtd; ++k) saidaPrintf(out, "%s %s", k ? "," : "", nomeSuspeito(ht, ids[k]));
+        saidaPrintf(out, "\n");
+    }
+    free(ids);
+    free(pistas);
+}
+
+/* explorarSalas: interação com o jogador a partir da sala atual de 'nav'
+   (o Hall, ou onde a sessão retomada parou); mantém pilha para voltar */
+void explorarSalas(const Mansao *m, Investigacao *inv, HashTable *ht, Navegacao *nav,
+                   const char *arqSessao, Saida *out) {
+    if (m->qtd == 0) return;
+
+    PlanejadorRota rota;
+    int temPlanejador = 0;      /* vetores da busca só são alocados no primeiro 'c' */
+    IndiceTrigramas trigramas;
+    int temTrigramas = 0;       /* montado na primeira busca por trecho; depois, uma inserção por pista nova */
+    const PoolStrings *ps = ht->strings;
+    char entrada[16];
+    int sair = 0, redesenhar = 1;
+
+    while (!sair) {
+        /* a tela da sala só é refeita depois de um movimento; os demais comandos
+           escrevem só a própria saída e voltam ao prompt */
+        if (redesenhar) {
+            const Sala *atual = &m->salas[nav->atual];
+            saidaPrintf(out, "\nVocê está em: %s\n", texto(ps, atual->nome));
+
+            /* coleta de pista, se existir */
+            int nova;
+            BSTNode *n = visitarSala(m, inv, ht, nav->atual, &nova);
+            if (n && nova && temTrigramas) acrescentarTrigramas(&trigramas, ps, n->pista);
+            if (n) {
+                if (nova)
+                    saidaPrintf(out, "Você encontrou uma pista: \"%s\"\n", texto(ps, n->pista));
+                else
+                    saidaPrintf(out, "Você já coletou a pista aqui: \"%s\" (já coletada %d vez(es)).\n",
+                                texto(ps, n->pista), n->contador);
+
+                const char *s = nomeSuspeito(ht, n->suspeito);
+                if (s) {
+                    saidaPrintf(out, "-> Esta pista aponta para: %s", s);
+                    imprimirDemaisSuspeitos(out, ht, n->pista, n->suspeito);
+                    saidaPrintf(out, "\n");
+                } else
+                    saidaPrintf(out, "-> Esta pista não está associada a nenhum suspeito conhecido.\n");
+            } else {
+                saidaPrintf(out, "Nenhuma pista aparente nesta sala.\n");
+            }
+
+            /* placar ao vivo: lido direto do ranking mantido a cada coleta (empatados
+               depois do primeiro saem em ordem não definida; a contagem é mostrada) */
+            const int *lideres;
+            size_t qtdLideres = suspeitosEmDestaque(inv, DESTAQUE_TOP, &lideres);
+            if (qtdLideres > 0) {
+                saidaPrintf(out, "Suspeitos em destaque:");
+                for (size_t k = 0; k < qtdLideres; ++k)
+                    saidaPrintf(out, "%s %s (%d)", k ? "," : "", nomeSuspeito(ht, lideres[k]),
+                                inv->pistasPorSuspeito[lideres[k]]);
+                saidaPrintf(out, "\n");
+            }
+
+            /* Opções de movimento (inclui 'b' para voltar quando possível) */
+            saidaPrintf(out, "\nOpções de movimento:\n");
+            if (atual->esquerda != SALA_NENHUMA)
+                saidaPrintf(out, " - (e) Ir para %s\n", texto(ps, m->salas[atual->esquerda].nome));
+            if (atual->direita != SALA_NENHUMA)
+                saidaPrintf(out, " - (d) Ir para %s\n", texto(ps, m->salas[atual->direita].nome));
+            if (nav->topo > 0)
+                saidaPrintf(out, " - (b) Voltar para %s\n", texto(ps, m->salas[nav->pilha[nav->topo - 1]].nome));
+            uint32_t pai = salaPai(m, nav->atual);
+            if (pai != SALA_NENHUMA && (nav->topo == 0 || pai != nav->pilha[nav->topo - 1]))
+                saidaPrintf(out, " - (p) Subir para %s\n", texto(ps, m->salas[pai].nome));
+            /* saídas do grafo além da visão de árvore (laços, portas extras) */
+            uint32_t extra;
+            for (size_t k = 0; (extra = saidaExtra(m, nav->atual, k)) != SALA_NENHUMA; ++k)
+                saidaPrintf(out, " - (v%zu) Passar para %s\n", k, texto(ps, m->salas[extra].nome));
+            if (nav->qtdFrente > 0)
+                saidaPrintf(out, " - (f) Avançar para %s\n",
+                            texto(ps, m->salas[nav->frente[nav->qtdFrente - 1]].nome));
+            if (nav->topo > 1) saidaPrintf(out, " - (h) Ver histórico / (jN) voltar direto à sala N\n");
+            if (inv->pistasDistintas > 0) saidaPrintf(out, " - (i) Suspeitos compatíveis com todas as pistas\n");
+            if (arqSessao) saidaPrintf(out, " - (g) Gravar a sessão para continuar depois\n");
+            saidaPrintf(out, " - (s) Sair da exploração\n");
+        }
+        redesenhar = 0;
+        saidaPrintf(out, "Escolha: ");
+        saidaDescarregar(out); /* uma escrita por tela, antes de esperar o jogador */
+
+        if (scanf("%15s", entrada) != 1) {
+            if (feof(stdin)) {
+                saidaPrintf(out, "\nFim da entrada. Exploração encerrada.\n");
+                saidaDescarregar(out);
+                break;
+            }
+            int c;
+            while ((c = getchar()) != '\n' && c != EOF) {}
+            saidaPrintf(out, "Entrada inválida. Tente novamente.\n");
+            continue;
+        }
+
+        if ((entrada[0] == 'h' || entrada[0] == 'H') && entrada[1] == '\0') {
+            saidaPrintf(out, "Histórico (mais antiga primeiro):\n");
+            for (size_t k = 0; k < nav->topo; ++k)
+                saidaPrintf(out, "  j%zu) %s\n", k, texto(ps, m->salas[nav->pilha[k]].nome));
+            continue;
+        }
+
+        if ((entrada[0] == 'g' || entrada[0] == 'G') && entrada[1] == '\0') {
+            if (!arqSessao)
+                saidaPrintf(out, "Sem arquivo de sessão (inicie com --sessao arquivo.dqs).\n");
+            else if (salvarSessao(arqSessao, m, ht, inv, nav) == 0)
+                saidaPrintf(out, "Sessão gravada em %s.\n", arqSessao);
+            else
+                saidaPrintf(out, "Não foi possível gravar a sessão.\n");
+            continue;
+        }
+
+        if ((entrada[0] == 'i' || entrada[0] == 'I') && entrada[1] == '\0') {
+            imprimirCompativeis(out, inv, ht);
+            continue;
+        }
+
+        if ((entrada[0] == 'c' || entrada[0] == 'C') && entrada[1] == '\0') {
+            if (!temPlanejador) { iniciarPlanejador(&rota, m); temPlanejador = 1; }
+            size_t passos;
+            uint32_t destino = planejarRotaPista(&rota, m, inv, nav->atual, &passos);
+            if (destino == SALA_NENHUMA) {
+                saidaPrintf(out, "Não há pistas pendentes alcançáveis daqui.\n");
+            } else {
+                saidaPrintf(out, "Pista pendente mais próxima: %s (%zu passo(s)):", texto(ps, m->salas[destino].nome), passos);
+                for (size_t k = 0; k <= passos; ++k)
+                    saidaPrintf(out, "%s%s", k ? " -> " : " ", texto(ps, m->salas[rota.rota[k]].nome));
+                saidaPrintf(out, "\n");
+            }
+            continue;
+        }
+
+        if ((entrada[0] == 'q' || entrada[0] == 'Q') && entrada[1] == '\0') {
+            char consulta[256];
+            saidaPrintf(out, "Buscar nas pistas (trecho, ou prefixo terminado em *): ");
+            saidaDescarregar(out);
+            if (scanf(" %255[^\n]", consulta) != 1) {
+                saidaPrintf(out, "\nFim da entrada. Exploração encerrada.\n");
+                saidaDescarregar(out);
+                break;
+            }
+            size_t n = inv->pistasDistintas, achadas;
+            StrId *res = (StrId*) malloc((n ? n : 1) * sizeof(StrId));
+            if (!res) { fprintf(stderr, "Erro de memória (busca)\n"); exit(EXIT_FAILURE); }
+            size_t tam = strlen(consulta);
+            if (tam > 0 && consulta[tam - 1] == '*') {
+                consulta[tam - 1] = '\0';
+                achadas = buscarPistasPorPrefixo(ps, inv->raizPistas, consulta, res, n);
+            } else {
+                if (!temTrigramas) {
+                    buscarPistasPorPrefixo(ps, inv->raizPistas, "", res, n); /* todas, em ordem */
+                    indexarTrigramas(&trigramas, ps, res, n);
+                    temTrigramas = 1;
+                }
+                achadas = buscarPorTrecho(&trigramas, ps, consulta, res, n);
+            }
+            saidaPrintf(out, "%zu pista(s) encontrada(s):\n", achadas);
+            for (size_t k = 0; k < achadas; ++k) saidaPrintf(out, " - \"%s\"\n", texto(ps, res[k]));
+            free(res);
+            continue;
+        }
+
+        char comando = entrada[1] == '\0' ? entrada[0] : '?';
+        ResultadoMovimento r;
+        if (comando == 't' || comando == 'T') {
+            char nome[256];
+            saidaPrintf(out, "Nome da sala: ");
+            saidaDescarregar(out);
+            if (scanf(" %255[^\n]", nome) != 1) {
+                saidaPrintf(out, "\nFim da entrada. Exploração encerrada.\n");
+                saidaDescarregar(out);
+                break;
+            }
+            uint32_t destino = buscarSalaPorNome(m, nome);
+            if (destino == SALA_NENHUMA) {
+                saidaPrintf(out, "Não existe sala chamada \"%s\".\n", nome);
+                continue;
+            }
+            r = irParaSala(m, nav, destino);
+        } else if ((entrada[0] == 'v' || entrada[0] == 'V') && entrada[1] >= '0' && entrada[1] <= '9') {
+            comando = 'v';
+            r = passarPor(m, nav, strtoul(entrada + 1, NULL, 10));
+        } else if ((entrada[0] == 'j' || entrada[0] == 'J') && entrada[1] >= '0' && entrada[1] <= '9') {
+            comando = 'j';
+            r = saltarHistorico(nav, strtoul(entrada + 1, NULL, 10));
+        } else {
+            r = moverJogador(m, nav, comando);
+        }
+        switch (r) {
+        case MOV_OK:
+            redesenhar = 1;
+            break;
+        case MOV_SEM_CAMINHO:
+            if (comando == 'e' || comando == 'E') saidaPrintf(out, "Caminho à esquerda inexistente.\n");
+            else if (comando == 'p' || comando == 'P') saidaPrintf(out, "Não há sala acima desta.\n");
+            else saidaPrintf(out, "Caminho à direita inexistente.\n");
+            break;
+        case MOV_SEM_ANTERIOR:
+            saidaPrintf(out, "Não há sala anterior para voltar.\n");
+            break;
+        case MOV_SEM_PROXIMA:
+            saidaPrintf(out, "Não há sala para avançar (use 'b' antes).\n");
+            break;
+        case MOV_SAIR:
+            saidaPrintf(out, "Exploração encerrada pelo jogador.\n");
+            saidaDescarregar(out);
+            sair = 1;
+            break;
+        case MOV_INVALIDO:
+            if (comando == 'j') saidaPrintf(out, "Posição inexistente no histórico (veja com 'h').\n");
+            else if (comando == 'v') saidaPrintf(out, "Saída inexistente nesta sala.\n");
+            else saidaPrintf(out, "Opção inválida. Use e, d, p, vN, b, f, h, jN, c, q, i, t, g ou s.\n");
+            break;
+        }
+    }
+    if (temPlanejador) liberarPlanejador(&rota);
+    if (temTrigramas) liberarTrigramas(&trigramas);
+}
+
+/* executarLote: cada linha de 'entrada' é uma sessão independente (comandos
+   e/d/p/b/f/c/s, jN e vN; 'c' dá um passo rumo à pista pendente mais próxima;
+   espaços ignorados; a sessão termina em 's' ou no fim da linha).
+   Sem menus: para cada sessão grava um registro
+      sessao;passos;invalidos;sala_final;pistas;suspeito_mais_citado;coletas_dele
+   Arena e contadores da investigação são reaproveitados entre sessões. */
+int executarLote(const Mansao *m, HashTable *ht, FILE *entrada, FILE *saida) {
+    if (m->qtd == 0) return -1;
+    Investigacao inv;
+    inicializarInvestigacao(&inv);
+    Navegacao nav;
+    iniciarNavegacao(&nav, m);
+    PlanejadorRota rota;
+    iniciarPlanejador(&rota, m);
+    char *linha = NULL;
+    size_t capLinha = 0;
+    ssize_t len;
+    size_t sessao = 0;
+
+    fprintf(saida, "sessao;passos;invalidos;sala_final;pistas;mais_citado;coletas\n");
+    while ((len = getline(&linha, &capLinha, entrada)) != -1) {
+        reiniciarInvestigacao(&inv);
+        reiniciarNavegacao(&nav);
+        int nova;
+        visitarSala(m, &inv, ht, nav.atual, &nova);
+        size_t passos = 0, invalidos = 0;
+
+        for (ssize_t i = 0; i < len; ++i) {
+            char c = linha[i];
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+            ResultadoMovimento r;
+            if ((c == 'j' || c == 'J' || c == 'v' || c == 'V') &&
+                i + 1 < len && linha[i + 1] >= '0' && linha[i + 1] <= '9') {
+                char *fim;
+                unsigned long k = strtoul(linha + i + 1, &fim, 10);
+                r = (c == 'j' || c == 'J') ? saltarHistorico(&nav, k) : passarPor(m, &nav, k);
+                i = fim - linha - 1;
+            } else if (c == 'c' || c == 'C') {
+                /* um passo na rota até a pista pendente mais próxima */
+                size_t n;
+                r = planejarRotaPista(&rota, m, &inv, nav.atual, &n) != SALA_NENHUMA && n > 0
+                        ? irParaSala(m, &nav, rota.rota[1]) : MOV_SEM_CAMINHO;
+            } else {
+                r = moverJogador(m, &nav, c);
+            }
+            if (r == MOV_SAIR) break;
+            if (r == MOV_OK) {
+                passos++;
+                visitarSala(m, &inv, ht, nav.atual, &nova);
+            } else {
+                invalidos++;
+            }
+        }
+
+        /* em empate, o primeiro suspeito a atingir a maior contagem */
+        const char *suspeito = nomeSuspeito(ht, inv.maisCitado);
+        fprintf(saida, "%zu;%zu;%zu;%s;%zu;%s;%d\n", ++sessao, passos, invalidos,
+                texto(ht->strings, m->salas[nav.atual].nome), inv.pistasDistintas,
+                suspeito ? suspeito : "-", suspeito ? inv.pistasPorSuspeito[inv.maisCitado] : 0);
+    }
+
+    free(linha);
+    liberarPlanejador(&rota);
+    liberarNavegacao(&nav);
+    liberarInvestigacao(&inv);
+    return ferror(entrada) ? -1 : 0;
+}
+
+/* -------------------- Simulação paralela -------------------- */
+
+/* Fatia de sessões de uma thread; o resultado é local (sem travas no caminho quente) */
+typedef struct {
+    const Mansao *m;
+    const HashTable *ht;
+    const MatrizEvidencias *ev;
+    const ParametrosSimulacao *p;
+    size_t inicio, fim;         /* sessões [inicio, fim) */
+    ResultadoSimulacao r;
+} TrabalhoSimulacao;
+
+/* misturar64: finalizador splitmix64, gera a semente de cada sessão */
+static uint64_t misturar64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/* proximoAleatorio: xorshift64 (estado nunca zero) */
+static uint64_t proximoAleatorio(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    return *s = x;
+}
+
+/* executarTrabalho: corpo da thread; mapa, hash e evidências só são lidos */
+static void* executarTrabalho(void *arg) {
+    TrabalhoSimulacao *t = arg;
+    const Mansao *m = t->m;
+    ResultadoSimulacao local = t->r;  /* na pilha: evita compartilhamento falso entre trabalhos vizinhos */
+    ResultadoSimulacao *r = &local;
+    Investigacao inv;
+    inicializarInvestigacao(&inv);
+    Navegacao nav;
+    iniciarNavegacao(&nav, m);
+    PontuacaoSuspeitos pt;      /* vetores da pontuação reaproveitados entre sessões */
+    memset(&pt, 0, sizeof pt);
+    int nova;
+
+    for (size_t s = t->inicio; s < t->fim; ++s) {
+        uint64_t estado = misturar64(t->p->semente ^ s) | 1;
+        reiniciarInvestigacao(&inv);
+        reiniciarNavegacao(&nav);
+        visitarSala(m, &inv, t->ht, nav.atual, &nova);
+
+        for (unsigned k = 0; k < t->p->passos; ++k) {
+            /* sorteia entre as saídas disponíveis (esquerda, direita, voltar) */
+            const Sala *atual = &m->salas[nav.atual];
+            char opcoes[3];
+            int n = 0;
+            if (atual->esquerda != SALA_NENHUMA) opcoes[n++] = 'e';
+            if (atual->direita != SALA_NENHUMA) opcoes[n++] = 'd';
+            if (nav.topo > 0) opcoes[n++] = 'b';
+            if (n == 0) break;
+            if (moverJogador(m, &nav, opcoes[proximoAleatorio(&estado) % n]) != MOV_OK) continue;
+            r->passos++;
+            visitarSala(m, &inv, t->ht, nav.atual, &nova);
+        }
+
+        /* veredito: acusa o suspeito de maior peso, com a mesma regra do jogo
+           (verificarSuspeitoFinal): válida se o peso chega a EVIDENCIA_MINIMA.
+           Num empate de peso fica o mais citado, se ele estiver no empate */
+        r->sessoes++;
+        r->pistas += inv.pistasDistintas;
+        if (pontuarSuspeitos(t->ev, &inv, &pt) == 0) {
+            r->semSuspeito++;
+            continue;
+        }
+        int acusado = pt.ranking[0];
+        if (inv.maisCitado >= 0 && (size_t) inv.maisCitado < t->ev->qtdSuspeitos &&
+            pt.pontos[inv.maisCitado] == pt.pontos[acusado])
+            acusado = inv.maisCitado;
+        if (pt.pontos[acusado] >= EVIDENCIA_MINIMA) {
+            r->validas++;
+            r->votos[acusado]++;
+        } else {
+            r->fracas++;
+        }
+    }
+
+    liberarPontuacao(&pt);
+    liberarNavegacao(&nav);
+    liberarInvestigacao(&inv);
+    t->r = local;
+    ESTAT(fundirEstatisticas());
+    return NULL;
+}
+
+/* simularInvestigacoes: divide as sessões em fatias contíguas, uma por thread.
+   O mapa, a hash e as evidências (já montadas) precisam estar completos: nada
+   neles é alterado aqui. Retorna 0, ou -1 se não foi possível criar as threads. */
+int simularInvestigacoes(const Mansao *m, const HashTable *ht, const MatrizEvidencias *ev,
+                         const ParametrosSimulacao *p, ResultadoSimulacao *r) {
+    memset(r, 0, sizeof(*r));
+    r->qtdSuspeitos = ht->suspeitos.qtd;
+    r->votos = calloc(r->qtdSuspeitos ? r->qtdSuspeitos : 1, sizeof(size_t));
+    if (!r->votos) { fprintf(stderr, "Erro de memória (simulação)\n"); exit(EXIT_FAILURE); }
+    if (m->qtd == 0) return -1;
+
+    unsigned nThreads = p->threads ? p->threads : 1;
+    if (nThreads > SIM_THREADS_MAX) nThreads = SIM_THREADS_MAX;
+    if (nThreads > p->sessoes && p->sessoes > 0) nThreads = (unsigned) p->sessoes;
+
+    TrabalhoSimulacao *trab = calloc(nThreads, sizeof(TrabalhoSimulacao));
+    pthread_t *ids = malloc(nThreads * sizeof(pthread_t));
+    if (!trab || !ids) { fprintf(stderr, "Erro de memória (simulação)\n"); exit(EXIT_FAILURE); }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    unsigned criadas = 0;
+    int erro = 0;
+    for (unsigned i = 0; i < nThreads; ++i) {
+        TrabalhoSimulacao *t = &trab[i];
+        t->m = m;
+        t->ht = ht;
+        t->ev = ev;
+        t->p = p;
+        t->inicio = p->sessoes * i / nThreads;
+        t->fim = p->sessoes * (i + 1) / nThreads;
+        t->r.votos = calloc(r->qtdSuspeitos ? r->qtdSuspeitos : 1, sizeof(size_t));
+        if (!t->r.votos) { fprintf(stderr, "Erro de memória (simulação)\n"); exit(EXIT_FAILURE); }
+        if (pthread_create(&ids[i], NULL, executarTrabalho, t) != 0) { erro = -1; break; }
+        criadas++;
+    }
+
+    /* agregação depois do join: cada thread só escreveu no próprio resultado */
+    for (unsigned i = 0; i < criadas; ++i) {
+        pthread_join(ids[i], NULL);
+        const ResultadoSimulacao *tr = &trab[i].r;
+        r->sessoes += tr->sessoes;
+        r->validas += tr->validas;
+        r->fracas += tr->fracas;
+        r->semSuspeito += tr->semSuspeito;
+        r->passos += tr->passos;
+        r->pistas += tr->pistas;
+        for (size_t k = 0; k < r->qtdSuspeitos; ++k) r->votos[k] += tr->votos[k];
+    }
+    for (unsigned i = 0; i < nThreads; ++i) free(trab[i].r.votos);
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    r->segundos = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    free(trab);
+    free(ids);
+    return erro;
+}
+
+/* liberarResultadoSimulacao: libera o vetor de votos */
+void liberarResultadoSimulacao(ResultadoSimulacao *r) {
+    free(r->votos);
+    r->votos = NULL;
+    r->qtdSuspeitos = 0;
+}
+
+/* imprimirPistasComContagem: in-order iterativo (ordem alfabética) com pilha
+   limitada pela altura da AVL */
+void imprimirPistasComContagem(BSTNode *raiz, HashTable *ht, Saida *out) {
+    const BSTNode *pilha[BST_ALTURA_MAX];
+    int topo = 0;
+    const BSTNode *n = raiz;
+    while (n || topo > 0) {
+        for (; n; n = n->esq) {
+            if (topo == BST_ALTURA_MAX) {
+                fprintf(stderr, "Erro: BST mais alta que BST_ALTURA_MAX.\n");
+                exit(EXIT_FAILURE);
+            }
+            pilha[topo++] = n;
+        }
+        n = pilha[--topo];
+        const char *pista = texto(ht->strings, n->pista);
+        const char *sus = nomeSuspeito(ht, n->suspeito);
+        if (sus) {
+            saidaPrintf(out, " - \"%s\" (coletada %d vez(es)) => aponta para: %s", pista, n->contador, sus);
+            imprimirDemaisSuspeitos(out, ht, n->pista, n->suspeito);
+            saidaPrintf(out, "\n");
+        } else
+            saidaPrintf(out, " - \"%s\" (coletada %d vez(es)) => aponta para: (nenhum)\n", pista, n->contador);
+        n = n->dir;
+    }
+}
+
+/* coletarSuspeitosUnicos: uma passada pelos slots conta as pistas de cada id;
+   outra pelos ids monta a lista de distintos e o mais citado. O(slots + suspeitos). */
+void coletarSuspeitosUnicos(const HashTable *ht, ResumoSuspeitos *r) {
+    size_t total = ht->suspeitos.qtd;
+    r->qtd = 0;
+    r->maisCitado = -1;
+    r->pistas = (size_t*) calloc(total ? total : 1, sizeof(size_t));
+    r->ids = (int*) malloc((total ? total : 1) * sizeof(int));
+    ESTAT_ALOC(EST_RESUMO, (total ? total : 1) * (sizeof(size_t) + sizeof(int)));
+    if (!r->pistas || !r->ids) { fprintf(stderr, "Erro de memória (suspeitos)\n"); exit(EXIT_FAILURE); }
+
+    for (size_t i = 0; i < ht->capacidade; ++i) {
+        if (ht->slots[i].dist == 0) continue;
+        CursorSuspeitos c;
+        abrirSuspeitos(ht, &ht->slots[i], &c);
+        for (int id; (id = proximoSuspeito(&c)) >= 0; ) r->pistas[id]++;
+    }
+
+    /* ids sem pistas pertencem a suspeitos substituídos em inserirNaHash */
+    for (size_t id = 0; id < total; ++id) {
+        if (r->pistas[id] == 0) continue;
+        r->ids[r->qtd++] = (int) id;
+        if (r->maisCitado < 0 || r->pistas[id] > r->pistas[r->maisCitado])
+            r->maisCitado = (int) id;
+    }
+}
+
+/* liberarResumoSuspeitos: libera os vetores do resumo */
+void liberarResumoSuspeitos(ResumoSuspeitos *r) {
+    free(r->ids);
+    free(r->pistas);
+    r->ids = NULL;
+    r->pistas = NULL;
+    r->qtd = 0;
+}
+
+/* imprime lista de suspeitos conhecidos, com nº de pistas, e o mais citado */
+void imprimirSuspeitos(HashTable *ht, Saida *out) {
+    ResumoSuspeitos r;
+    coletarSuspeitosUnicos(ht, &r);
+    if (r.qtd == 0) {
+        saidaPrintf(out, "Nenhum suspeito registrado no sistema.\n");
+        liberarResumoSuspeitos(&r);
+        return;
+    }
+    saidaPrintf(out, "\nSuspeitos conhecidos:\n");
+    for (size_t i = 0; i < r.qtd; ++i) {
+        int id = r.ids[i];
+        saidaPrintf(out, " %zu) %s (%zu pista(s))\n", i+1, nomeSuspeito(ht, id), r.pistas[id]);
+    }
+    saidaPrintf(out, "Suspeito mais citado: %s (%zu pista(s))\n",
+                nomeSuspeito(ht, r.maisCitado), r.pistas[r.maisCitado]);
+    liberarResumoSuspeitos(&r);
+}
+
+/* -------------------- Evidências ponderadas -------------------- */
+
+/* inicializarEvidencias: matriz vazia, pronta para receber triplas */
+void inicializarEvidencias(MatrizEvidencias *ev) {
+    memset(ev, 0, sizeof *ev);
+}
+
+/* adicionarEvidencia: acumula a tripla (pista, suspeito, peso). O suspeito é
+   internado na tabela da hash (mesmos ids do resto do jogo); pares repetidos
+   somam os pesos na montagem. Pesos <= 0 são ignorados. */
+void adicionarEvidencia(MatrizEvidencias *ev, HashTable *ht, StrId pista, StrId suspeito, float peso) {
+    if (pista == 0 || suspeito == 0 || !(peso > 0.0f)) return;
+    if (ev->qtdT == ev->capT) {
+        size_t nova = ev->capT ? ev->capT * 2 : 64;
+        uint32_t *l = (uint32_t*) realloc(ev->linhaT, nova * sizeof(uint32_t));
+        if (l) ev->linhaT = l;
+        int *su = (int*) realloc(ev->suspeitoT, nova * sizeof(int));
+        if (su) ev->suspeitoT = su;
+        float *pe = (float*) realloc(ev->pesoT, nova * sizeof(float));
+        if (pe) ev->pesoT = pe;
+        ESTAT_ALOC(EST_EVIDENCIAS, nova * (sizeof(uint32_t) + sizeof(int) + sizeof(float)));
+        if (!l || !su || !pe) { fprintf(stderr, "Erro de memória (evidências)\n"); exit(EXIT_FAILURE); }
+        ev->capT = nova;
+    }
+    ev->linhaT[ev->qtdT] = (uint32_t) internarSimbolo(&ev->pistas, pista);
+    ev->suspeitoT[ev->qtdT] = internarSimbolo(&ht->suspeitos, suspeito);
+    ev->pesoT[ev->qtdT] = peso;
+    ev->qtdT++;
+}
+
+/* montarEvidencias: completa com as associações da hash cujas pistas não
+   receberam triplas (peso 1) e monta o CSR por contagem: O(triplas + pistas).
+   Repetições de um par numa linha viram uma entrada (pesos somados). */
+void montarEvidencias(MatrizEvidencias *ev, HashTable *ht) {
+    for (size_t i = 0; i < ht->capacidade; ++i) {
+        const HashEntry *e = &ht->slots[i];
+        if (e->dist == 0 || buscarSimbolo(&ev->pistas, e->pista) >= 0) continue;
+        CursorSuspeitos c;
+        abrirSuspeitos(ht, e, &c);
+        for (int id; (id = proximoSuspeito(&c)) >= 0; )
+            adicionarEvidencia(ev, ht, e->pista, simboloStr(&ht->suspeitos, id), 1.0f);
+    }
+    size_t linhas = ev->pistas.qtd;
+    free(ev->inicio);
+    free(ev->suspeito);
+    free(ev->peso);
+    ev->inicio = (uint32_t*) calloc(linhas + 2, sizeof(uint32_t));
+    ev->suspeito = (int*) malloc((ev->qtdT ? ev->qtdT : 1) * sizeof(int));
+    ev->peso = (float*) malloc((ev->qtdT ? ev->qtdT : 1) * sizeof(float));
+    ev->qtdSuspeitos = ht->suspeitos.qtd;
+    /* marca[s] = posição + 1 da entrada de s na linha em montagem (reinicia por linha) */
+    uint32_t *marca = (uint32_t*) calloc(ev->qtdSuspeitos ? ev->qtdSuspeitos : 1, sizeof(uint32_t));
+    uint32_t *ordem = (uint32_t*) malloc((ev->qtdT ? ev->qtdT : 1) * sizeof(uint32_t));
+    ESTAT_ALOC(EST_EVIDENCIAS, (linhas + 2) * sizeof(uint32_t) + ev->qtdT * (sizeof(int) + sizeof(float)));
+    if (!ev->inicio || !ev->suspeito || !ev->peso || !marca || !ordem || ev->qtdT > UINT32_MAX) {
+        fprintf(stderr, "Erro de memória (evidências)\n");
+        exit(EXIT_FAILURE);
+    }
+    /* ordenação estável das triplas por linha */
+    uint32_t *cont = ev->inicio + 1;
+    for (size_t k = 0; k < ev->qtdT; ++k) cont[ev->linhaT[k] + 1]++;
+    for (size_t l = 0; l < linhas; ++l) cont[l + 1] += cont[l];
+    for (size_t k = 0; k < ev->qtdT; ++k) ordem[cont[ev->linhaT[k]]++] = (uint32_t) k;
+
+    /* agora cont[l] = fim da linha l nas triplas ordenadas; compacta os pares repetidos */
+    size_t saida = 0, ini = 0;
+    ev->inicio[0] = 0;
+    for (size_t l = 0; l < linhas; ++l) {
+        size_t fim = cont[l];
+        size_t base = saida;
+        for (size_t k = ini; k < fim; ++k) {
+            uint32_t t = ordem[k];
+            int s = ev->suspeitoT[t];
+            if (marca[s] > base) { ev->peso[marca[s] - 1] += ev->pesoT[t]; continue; }
+            ev->suspeito[saida] = s;
+            ev->peso[saida] = ev->pesoT[t];
+            marca[s] = (uint32_t) ++saida;
+        }
+        for (size_t k = base; k < saida; ++k) marca[ev->suspeito[k]] = 0;
+        ev->inicio[l + 1] = (uint32_t) saida;
+        ini = fim;
+    }
+    ev->qtdEntradas = saida;
+    ev->qtdLinhas = linhas;
+    free(marca);
+    free(ordem);
+    free(ev->linhaT);
+    free(ev->suspeitoT);
+    free(ev->pesoT);
+    ev->linhaT = NULL;
+    ev->suspeitoT = NULL;
+    ev->pesoT = NULL;
+    ev->qtdT = ev->capT = 0;
+}
+
+/* compararPontos: maior pontuação primeiro; empate pelo menor id */
+static int compararPontos(const void *a, const void *b, const double *pontos) {
+    int x = *(const int*) a, y = *(const int*) b;
+    if (pontos[x] != pontos[y]) return pontos[x] > pontos[y] ? -1 : 1;
+    return (x > y) - (x < y);
+}
+
+/* ordenarRanking: ordenação por inserção nas faixas curtas e mergesort
+   (com buffer) acima disso; qsort não recebe contexto em C11 */
+static void ordenarRanking(int *v, int *tmp, size_t n, const double *pontos) {
+    if (n <= 16) {
+        for (size_t i = 1; i < n; ++i) {
+            int x = v[i];
+            size_t j = i;
+            for (; j > 0 && compararPontos(&v[j - 1], &x, pontos) > 0; --j) v[j] = v[j - 1];
+            v[j] = x;
+        }
+        return;
+    }
+    size_t meio = n / 2;
+    ordenarRanking(v, tmp, meio, pontos);
+    ordenarRanking(v + meio, tmp, n - meio, pontos);
+    size_t i = 0, j = meio, k = 0;
+    while (i < meio && j < n) tmp[k++] = compararPontos(&v[j], &v[i], pontos) < 0 ? v[j++] : v[i++];
+    while (i < meio) tmp[k++] = v[i++];
+    memcpy(v, tmp, k * sizeof(int)); /* o resto de [j, n) já está no lugar */
+}
+
+/* pontuarSuspeitos: uma passada pelas pistas coletadas soma peso x coletas
+   de cada entrada da linha da pista; os suspeitos atingidos entram no
+   ranking na primeira soma. Depois, só o ranking é ordenado.
+   Custo: O(pistas coletadas + entradas lidas + r log r), r = suspeitos pontuados. */
+size_t pontuarSuspeitos(const MatrizEvidencias *ev, const Investigacao *inv, PontuacaoSuspeitos *pt) {
+    if (pt->cap < ev->qtdSuspeitos || pt->cap == 0) {
+        free(pt->pontos);
+        free(pt->ranking);
+        pt->cap = ev->qtdSuspeitos ? ev->qtdSuspeitos : 1;
+        pt->pontos = (double*) calloc(pt->cap, sizeof(double));
+        pt->ranking = (int*) malloc(2 * pt->cap * sizeof(int)); /* 2ª metade: buffer da ordenação */
+        ESTAT_ALOC(EST_EVIDENCIAS, pt->cap * (sizeof(double) + 2 * sizeof(int)));
+        if (!pt->pontos || !pt->ranking) { fprintf(stderr, "Erro de memória (pontuação)\n"); exit(EXIT_FAILURE); }
+    } else {
+        for (size_t k = 0; k < pt->qtdRanking; ++k) pt->pontos[pt->ranking[k]] = 0.0;
+    }
+    pt->qtdRanking = 0;
+    pt->total = 0.0;
+
+    const BSTNode *pilha[BST_ALTURA_MAX];
+    int topo = 0;
+    const BSTNode *n = inv->raizPistas;
+    while (n || topo > 0) {
+        for (; n; n = n->esq) pilha[topo++] = n; /* altura limitada por BST_ALTURA_MAX na inserção */
+        n = pilha[--topo];
+        int l = buscarSimbolo(&ev->pistas, n->pista);
+        if (l >= 0 && (size_t) l < ev->qtdLinhas) {
+            double coletas = n->contador;
+            for (uint32_t k = ev->inicio[l]; k < ev->inicio[l + 1]; ++k) {
+                int s = ev->suspeito[k];
+                if (pt->pontos[s] == 0.0) pt->ranking[pt->qtdRanking++] = s;
+                pt->pontos[s] += coletas * ev->peso[k];
+            }
+        }
+        n = n->dir;
+    }
+    for (size_t k = 0; k < pt->qtdRanking; ++k) pt->total += pt->pontos[pt->ranking[k]];
+    ordenarRanking(pt->ranking, pt->ranking + pt->cap, pt->qtdRanking, pt->pontos);
+    return pt->qtdRanking;
+}
+
+/* liberarEvidencias: libera CSR, triplas pendentes e índice das pistas */
+void liberarEvidencias(MatrizEvidencias *ev) {
+    free(ev->inicio);
+    free(ev->suspeito);
+    free(ev->peso);
+    free(ev->linhaT);
+    free(ev->suspeitoT);
+    free(ev->pesoT);
+    liberarSimbolos(&ev->pistas);
+    memset(ev, 0, sizeof *ev);
+}
+
+/* liberarPontuacao: libera os vetores da pontuação */
+void liberarPontuacao(PontuacaoSuspeitos *pt) {
+    free(pt->pontos);
+    free(pt->ranking);
+    memset(pt, 0, sizeof *pt);
+}
+
+/* imprimirProbabilidades: os EVIDENCIA_TOP suspeitos com mais peso acumulado */
+static void imprimirProbabilidades(const PontuacaoSuspeitos *pt, HashTable *ht, Saida *out) {
+    if (pt->qtdRanking == 0) return;
+    saidaPrintf(out, "\nProbabilidades pelas evidências ponderadas:\n");
+    for (size_t k = 0; k < pt->qtdRanking && k < EVIDENCIA_TOP; ++k) {
+        int id = pt->ranking[k];
+        saidaPrintf(out, " %zu) %s: %.1f%% (peso %.2f)\n", k + 1, nomeSuspeito(ht, id),
+                    100.0 * pt->pontos[id] / pt->total, pt->pontos[id]);
+    }
+}
+
+/* verificarSuspeitoFinal: mostra resumo, lista suspeitos e pede acusação.
+   Com 'ev', a acusação é válida se o peso acumulado contra o acusado chega a
+   EVIDENCIA_MINIMA (com pesos 1 e um suspeito por pista, o mesmo que >= 2 pistas). */
+void verificarSuspeitoFinal(Investigacao *inv, HashTable *ht, const MatrizEvidencias *ev, Saida *out) {
+    saidaPrintf(out, "\n========= RESUMO DA INVESTIGAÇÃO =========\n");
+
+    if (!inv->raizPistas) {
+        saidaPrintf(out, "Você não coletou nenhuma pista durante a exploração.\n");
+    } else {
+        saidaPrintf(out, "Pistas coletadas:\n");
+        imprimirPistasComContagem(inv->raizPistas, ht, out);
+    }
+
+    /* Mostrar suspeitos conhecidos */
+    imprimirSuspeitos(ht, out);
+    PontuacaoSuspeitos pt;
+    memset(&pt, 0, sizeof pt);
+    if (ev) {
+        pontuarSuspeitos(ev, inv, &pt);
+        imprimirProbabilidades(&pt, ht, out);
+    }
+
+    /* Perguntar pelo acusado */
+    char acusado[MAX_NAME];
+    saidaPrintf(out, "\nDigite o nome do suspeito que deseja acusar (ou deixe em branco para não acusar): ");
+    saidaDescarregar(out); /* resumo inteiro numa escrita */
+    /* limpar buffer até newline anterior */
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF) {}
+    if (fgets(acusado, sizeof(acusado), stdin) == NULL) {
+        saidaPrintf(out, "Entrada inválida.\n");
+        saidaDescarregar(out);
+        liberarPontuacao(&pt);
+        return;
+    }
+    /* remover newline */
+    size_t len = strlen(acusado);
+    if (len > 0 && acusado[len-1] == '\n') acusado[len-1] = '\0';
+
+    if (acusado[0] == '\0') {
+        saidaPrintf(out, "Nenhuma acusação realizada. Investigação encerrada.\n");
+        saidaDescarregar(out);
+        liberarPontuacao(&pt);
+        return;
+    }
+
+    int cont = contadorPistasParaSuspeito(inv, ht, acusado);
+    saidaPrintf(out, "\nPistas que apontam para '%s': %d\n", acusado, cont);
+    double peso = cont;
+    if (ev) {
+        int id = buscarSimbolo(&ht->suspeitos, buscarString(ht->strings, acusado));
+        peso = (id >= 0 && (size_t) id < ev->qtdSuspeitos) ? pt.pontos[id] : 0.0;
+        saidaPrintf(out, "Peso das evidências contra '%s': %.2f (%.1f%% do total)\n", acusado, peso,
+                    pt.total > 0 ? 100.0 * peso / pt.total : 0.0);
+    }
+    liberarPontuacao(&pt);
+    if (peso >= EVIDENCIA_MINIMA) {
+        saidaPrintf(out, "Acusação válida: existem evidências suficientes para prender %s.\n", acusado);
+    } else {
+        saidaPrintf(out, "Acusação fraca: não há pistas suficientes para culpar %s.\n", acusado);
+    }
+    saidaDescarregar(out);
+}
+
+/* liberarHash: libera o bloco de slots da hash (uma única desalocação) */
+void liberarHash(HashTable *ht) {
+    free(ht->slots);
+    ht->slots = NULL;
+    ht->capacidade = ht->qtd = 0;
+    free(ht->listas);
+    ht->listas = NULL;
+    ht->usadoListas = ht->capListas = ht->lixoListas = ht->qtdExtras = 0;
+    liberarSimbolos(&ht->suspeitos);
+}
+
+/* -------------------- Formato binário e formato texto da mansão -------------------- */
+
+/* gravarBloco: fwrite com verificação; 0 = ok */
+static int gravarBloco(FILE *f, const void *p, size_t tam) {
+    return (tam == 0 || fwrite(p, 1, tam, f) == tam) ? 0 : -1;
+}
+
+/* ordenarAssociacoes: associações principais da hash ordenadas por id de
+   suspeito (counting sort); ao recarregar, os suspeitos são internados na
+   mesma ordem e mantêm os ids. O vetor devolvido (ht->qtd entradas) é do chamador. */
+static AssocArquivo* ordenarAssociacoes(const HashTable *ht) {
+    size_t nSus = ht->suspeitos.qtd;
+    size_t *inicio = (size_t*) calloc(nSus + 1, sizeof(size_t));
+    AssocArquivo *assoc = (AssocArquivo*) malloc((ht->qtd ? ht->qtd : 1) * sizeof(AssocArquivo));
+    if (!inicio || !assoc) { fprintf(stderr, "Erro de memória (gravação)\n"); exit(EXIT_FAILURE); }
+    for (size_t i = 0; i < ht->capacidade; ++i)
+        if (ht->slots[i].dist) inicio[principalDaEntrada(ht, &ht->slots[i]) + 1]++;
+    for (size_t k = 0; k < nSus; ++k) inicio[k + 1] += inicio[k];
+    for (size_t i = 0; i < ht->capacidade; ++i) {
+        const HashEntry *e = &ht->slots[i];
+        if (e->dist == 0) continue;
+        int id = principalDaEntrada(ht, e);
+        AssocArquivo a = { e->pista, simboloStr(&ht->suspeitos, id) };
+        assoc[inicio[id]++] = a;
+    }
+    free(inicio);
+    return assoc;
+}
+
+/* listarAssociacoesExtras: pares pista->suspeito das listas que não são o
+   principal (ht->qtdExtras entradas), para gravar depois dos principais e
+   recarregar com acrescentarSuspeitoStr. O vetor é do chamador. */
+static AssocArquivo* listarAssociacoesExtras(const HashTable *ht) {
+    AssocArquivo *extras = (AssocArquivo*) malloc((ht->qtdExtras ? ht->qtdExtras : 1) * sizeof(AssocArquivo));
+    if (!extras) { fprintf(stderr, "Erro de memória (gravação)\n"); exit(EXIT_FAILURE); }
+    size_t n = 0;
+    for (size_t i = 0; i < ht->capacidade; ++i) {
+        const HashEntry *e = &ht->slots[i];
+        if (e->dist == 0 || e->suspeito >= 0) continue;
+        CursorSuspeitos c;
+        int principal = abrirSuspeitos(ht, e, &c);
+        for (int id; (id = proximoSuspeito(&c)) >= 0; ) {
+            if (id == principal) continue;
+            AssocArquivo a = { e->pista, simboloStr(&ht->suspeitos, id) };
+            extras[n++] = a;
+        }
+    }
+    return extras;
+}
+
+/* salvarMansaoBinaria: grava salas, associações da hash e o pool de strings.
+   Os StrId já são deslocamentos no pool, então são gravados sem tradução. */
+int salvarMansaoBinaria(const Mansao *m, const HashTable *ht, const char *caminho) {
+    if (m->strings != ht->strings) {
+        fprintf(stderr, "Erro: mapa e hash precisam compartilhar o mesmo pool de strings.\n");
+        return -1;
+    }
+    FILE *f = fopen(caminho, "wb");
+    if (!f) { perror(caminho); return -1; }
+
+    CabecalhoMansao cab;
+    memset(&cab, 0, sizeof cab);
+    memcpy(cab.magica, MANSAO_MAGICA, 4);
+    cab.versao = MANSAO_VERSAO;
+    cab.qtdSalas = m->qtd;
+    cab.qtdAssoc = (uint32_t) ht->qtd;
+    cab.qtdAssocExtras = (uint32_t) ht->qtdExtras;
+    cab.tamStrings = m->strings->usado;
+    cab.qtdPassagens = m->qtdPassagens;
+    cab.offSalas = sizeof cab;
+    cab.offPassagens = cab.offSalas + (uint64_t) m->qtd * sizeof(Sala);
+    cab.offIndice = cab.offPassagens + (uint64_t) m->qtdPassagens * sizeof(Passagem);
+    /* índice: os vetores do mapa, se já existem; senão, calculados aqui */
+    uint32_t *ini = m->inicioVizinhos, *viz = m->vizinhos;
+    if (!ini) ini = montarGrafo(m, &viz);
+    cab.qtdArestas = ini[m->qtd];
+    cab.offAssoc = cab.offIndice + (3 * (uint64_t) m->qtd + 1 + cab.qtdArestas) * sizeof(uint32_t);
+    cab.offStrings = cab.offAssoc + (uint64_t) (ht->qtd + ht->qtdExtras) * sizeof(AssocArquivo);
+
+    uint32_t *pai = m->pai, *ordem = m->ordemNomes, *tmp = NULL;
+    if (!pai) {
+        pai = (uint32_t*) malloc(((size_t) m->qtd + 1) * sizeof(uint32_t));
+        if (!pai) { fprintf(stderr, "Erro de memória (gravação da mansão)\n"); exit(EXIT_FAILURE); }
+        calcularPais(m->salas, m->qtd, pai);
+    }
+    if (!ordem) {
+        ordem = (uint32_t*) malloc(((size_t) m->qtd + 1) * sizeof(uint32_t));
+        tmp = (uint32_t*) malloc(((size_t) m->qtd + 1) * sizeof(uint32_t));
+        if (!ordem || !tmp) { fprintf(stderr, "Erro de memória (gravação da mansão)\n"); exit(EXIT_FAILURE); }
+        for (uint32_t i = 0; i < m->qtd; ++i) ordem[i] = i;
+        ordenarSalasPorNome(m, ordem, tmp, m->qtd);
+        free(tmp);
+    }
+
+    AssocArquivo *assoc = ordenarAssociacoes(ht);
+    AssocArquivo *extras = listarAssociacoesExtras(ht);
+    int erro = gravarBloco(f, &cab, sizeof cab) || gravarBloco(f, m->salas, (size_t) m->qtd * sizeof(Sala)) ||
+               gravarBloco(f, m->passagens, (size_t) m->qtdPassagens * sizeof(Passagem)) ||
+               gravarBloco(f, pai, (size_t) m->qtd * sizeof(uint32_t)) ||
+               gravarBloco(f, ordem, (size_t) m->qtd * sizeof(uint32_t)) ||
+               gravarBloco(f, ini, ((size_t) m->qtd + 1) * sizeof(uint32_t)) ||
+               gravarBloco(f, viz, (size_t) cab.qtdArestas * sizeof(uint32_t)) ||
+               gravarBloco(f, assoc, ht->qtd * sizeof(AssocArquivo)) ||
+               gravarBloco(f, extras, ht->qtdExtras * sizeof(AssocArquivo));
+    if (pai != m->pai) free(pai);
+    if (ordem != m->ordemNomes) free(ordem);
+    if (ini != m->inicioVizinhos) { free(ini); free(viz); }
+    free(assoc);
+    free(extras);
+    if (!erro) erro = gravarBloco(f, m->strings->dados, m->strings->usado);
+    if (fclose(f) != 0) erro = -1;
+    if (erro) fprintf(stderr, "Erro ao gravar %s\n", caminho);
+    return erro ? -1 : 0;
+}
+
+/* carregarMansaoBinaria: mapeia o arquivo e aponta salas, strings, pais,
+   ordem dos nomes e grafo para ele (sem cópia); só a hash é montada em memória.
+   Arquivos anteriores à versão 5 ganham o índice em memória (indexarMansao).
+   'ps' passa a referenciar o arquivo e deve ser liberado depois de 'm'. */
+int carregarMansaoBinaria(const char *caminho, Mansao *m, PoolStrings *ps, HashTable *ht) {
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) { perror(caminho); return -1; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < offsetof(CabecalhoMansao, qtdPassagens)) {
+        fprintf(stderr, "Erro: %s não é um arquivo de mansão válido.\n", caminho);
+        close(fd);
+        return -1;
+    }
+    size_t tam = (size_t) st.st_size;
+    void *mapa = mmap(NULL, tam, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED) { perror("mmap"); return -1; }
+
+    const unsigned char *base = (const unsigned char*) mapa;
+    const CabecalhoMansao *cab = (const CabecalhoMansao*) base;
+    const char *motivo = NULL;
+    uint32_t qtdPassagens = 0, qtdExtras = 0;
+    uint64_t offPassagens = 0;
+    if (memcmp(cab->magica, MANSAO_MAGICA, 4) != 0) motivo = "assinatura inválida";
+    else if (cab->versao == 0 || cab->versao > MANSAO_VERSAO) motivo = "versão não suportada";
+    else if ((cab->versao >= 2 && tam < offsetof(CabecalhoMansao, offIndice)) ||
+             (cab->versao >= 5 && tam < sizeof(CabecalhoMansao)))
+        motivo = "cabeçalho incompleto";
+    else if (cab->qtdSalas == 0 || cab->qtdSalas == SALA_NENHUMA) motivo = "quantidade de salas inválida";
+    else if (cab->tamStrings == 0 || cab->tamStrings > UINT32_MAX) motivo = "tabela de strings inválida";
+    else if (cab->offSalas % 4 || cab->offAssoc % 4 ||
+             cab->offSalas > tam || (uint64_t) cab->qtdSalas * sizeof(Sala) > tam - cab->offSalas ||
+             cab->offAssoc > tam || (uint64_t) cab->qtdAssoc * sizeof(AssocArquivo) > tam - cab->offAssoc ||
+             cab->offStrings > tam || cab->tamStrings > tam - cab->offStrings)
+        motivo = "seções fora do arquivo";
+    else if (base[cab->offStrings] != '\0' || base[cab->offStrings + cab->tamStrings - 1] != '\0')
+        motivo = "tabela de strings mal terminada";
+    if (!motivo && cab->versao >= 2) {
+        qtdPassagens = cab->qtdPassagens;
+        offPassagens = cab->offPassagens;
+        if (offPassagens % 4 || offPassagens > tam ||
+            (uint64_t) qtdPassagens * sizeof(Passagem) > tam - offPassagens)
+            motivo = "seções fora do arquivo";
+    }
+    if (!motivo && cab->versao >= 3) {
+        qtdExtras = cab->qtdAssocExtras;
+        if ((uint64_t) (cab->qtdAssoc + (uint64_t) qtdExtras) * sizeof(AssocArquivo) > tam - cab->offAssoc)
+            motivo = "seções fora do arquivo";
+    }
+    const uint32_t *pai = NULL, *ordem = NULL, *ini = NULL, *viz = NULL;
+    if (!motivo && cab->versao >= 5) {
+        if (cab->offIndice % 4 || cab->offIndice > tam ||
+            (3 * (uint64_t) cab->qtdSalas + 1 + cab->qtdArestas) * sizeof(uint32_t) > tam - cab->offIndice)
+            motivo = "seções fora do arquivo";
+        else {
+            pai = (const uint32_t*) (base + cab->offIndice);
+            ordem = pai + cab->qtdSalas;
+            ini = ordem + cab->qtdSalas;
+            viz = ini + cab->qtdSalas + 1;
+        }
+    }
+
+    /* validação sequencial dos índices: navegar depois não precisa checar limites */
+    const Sala *salas = (const Sala*) (base + (motivo ? 0 : cab->offSalas));
+    const AssocArquivo *assoc = (const AssocArquivo*) (base + (motivo ? 0 : cab->offAssoc));
+    for (uint32_t i = 0; !motivo && i < cab->qtdSalas; ++i) {
+        const Sala *s = &salas[i];
+        if (s->nome >= cab->tamStrings || s->pista >= cab->tamStrings ||
+            (s->esquerda != SALA_NENHUMA && s->esquerda >= cab->qtdSalas) ||
+            (s->direita != SALA_NENHUMA && s->direita >= cab->qtdSalas))
+            motivo = "sala com referência inválida";
+    }
+    const Passagem *passagens = (const Passagem*) (base + (motivo ? 0 : offPassagens));
+    for (uint32_t k = 0; !motivo && k < qtdPassagens; ++k)
+        if (passagens[k].a >= cab->qtdSalas || passagens[k].b >= cab->qtdSalas)
+            motivo = "passagem com referência inválida";
+    for (uint64_t i = 0; !motivo && i < (uint64_t) cab->qtdAssoc + qtdExtras; ++i)
+        if (assoc[i].pista >= cab->tamStrings || assoc[i].suspeito >= cab->tamStrings)
+            motivo = "associação com referência inválida";
+    /* índices gravados: só limites (uma ordem errada dá buscas erradas, não acessos inválidos) */
+    for (uint32_t i = 0; !motivo && pai && i < cab->qtdSalas; ++i)
+        if ((pai[i] != SALA_NENHUMA && pai[i] >= cab->qtdSalas) || ordem[i] >= cab->qtdSalas)
+            motivo = "índice da mansão com referência inválida";
+    for (uint32_t i = 0; !motivo && ini && i < cab->qtdSalas; ++i)
+        if (ini[i] > ini[i + 1]) motivo = "grafo com referência inválida";
+    if (!motivo && ini && (ini[0] != 0 || ini[cab->qtdSalas] != cab->qtdArestas))
+        motivo = "grafo com referência inválida";
+    for (uint32_t k = 0; !motivo && viz && k < cab->qtdArestas; ++k)
+        if (viz[k] >= cab->qtdSalas) motivo = "grafo com referência inválida";
+    if (motivo) {
+        fprintf(stderr, "Erro: %s: %s.\n", caminho, motivo);
+        munmap(mapa, tam);
+        return -1;
+    }
+
+    ps->dados = (char*) (base + cab->offStrings);
+    ps->usado = (size_t) cab->tamStrings;
+    ps->cap = 0;
+    ps->indice = NULL;
+    ps->capIndice = ps->qtd = 0;
+
+    inicializarMansao(m, ps);
+    m->salas = (Sala*) salas;
+    m->qtd = cab->qtdSalas;
+    m->passagens = (Passagem*) passagens;
+    m->qtdPassagens = qtdPassagens;
+    m->mapa = mapa;
+    m->tamMapa = tam;
+
+    if (pai) {
+        m->pai = (uint32_t*) pai;
+        m->ordemNomes = (uint32_t*) ordem;
+        m->inicioVizinhos = (uint32_t*) ini;
+        m->vizinhos = (uint32_t*) viz;
+        m->indiceMapeado = 1;
+    } else {
+        indexarMansao(m);
+    }
+
+    inicializarHash(ht, ps);
+    reservarHash(ht, cab->qtdAssoc);
+    for (uint32_t i = 0; i < cab->qtdAssoc; ++i)
+        inserirNaHashStr(ht, assoc[i].pista, assoc[i].suspeito);
+    for (uint32_t i = 0; i < qtdExtras; ++i)
+        acrescentarSuspeitoStr(ht, assoc[cab->qtdAssoc + i].pista, assoc[cab->qtdAssoc + i].suspeito);
+    return 0;
+}
+
+/* proximoCampo: separa o próximo campo delimitado por '|' (modifica a linha) */
+static char* proximoCampo(char **cursor) {
+    char *ini = *cursor;
+    if (!ini) return NULL;
+    char *sep = strchr(ini, '|');
+    if (sep) { *sep = '\0'; *cursor = sep + 1; }
+    else *cursor = NULL;
+    return ini;
+}
+
+/* salaPorNome: índice da sala com o nome; cria uma sala provisória se ainda não existir.
+   Os ids da tabela de símbolos coincidem com os índices porque ambos são sequenciais. */
+static uint32_t salaPorNome(Mansao *m, TabelaSimbolos *nomes, const char *nome) {
+    StrId s = internarString(m->strings, nome);
+    int id = buscarSimbolo(nomes, s);
+    if (id >= 0) return (uint32_t) id;
+    internarSimbolo(nomes, s);
+    return criarSala(m, nome, "");
+}
+
+/* carregarMansaoTexto: lê a descrição textual (uma linha por registro):
+      # comentário
+      sala|<nome>|<pista>|<sala à esquerda>|<sala à direita>   (campos vazios = nenhum)
+      pista|<texto da pista>|<suspeito>
+      passagem|<sala>|<sala>                                 (ligação extra, mão dupla)
+   A primeira sala declarada é o Hall; repetir a pista com outro suspeito
+   acrescenta-o à lista (o último é o principal). 'm' e 'ht' já devem estar inicializados. */
+int carregarMansaoTexto(const char *caminho, Mansao *m, HashTable *ht) {
+    FILE *f = fopen(caminho, "r");
+    if (!f) { perror(caminho); return -1; }
+
+    TabelaSimbolos nomes;
+    memset(&nomes, 0, sizeof nomes);
+    unsigned char *definida = NULL;   /* definida[i] = sala i teve sua linha 'sala' */
+    size_t capDefinida = 0;
+    char linha[LINHA_MAX];
+    int numLinha = 0, erro = 0;
+
+    while (!erro && fgets(linha, sizeof linha, f)) {
+        numLinha++;
+        linha[strcspn(linha, "\r\n")] = '\0';
+        if (linha[0] == '\0' || linha[0] == '#') continue;
+
+        char *cursor = linha;
+        char *tipo = proximoCampo(&cursor);
+        if (strcmp(tipo, "sala") == 0) {
+            char *nome = proximoCampo(&cursor);
+            char *pista = proximoCampo(&cursor);
+            char *esq = proximoCampo(&cursor);
+            char *dir = proximoCampo(&cursor);
+            if (!nome || nome[0] == '\0') {
+                fprintf(stderr, "%s:%d: sala sem nome\n", caminho, numLinha);
+                erro = -1;
+                break;
+            }
+            uint32_t id = salaPorNome(m, &nomes, nome);
+            if (id >= capDefinida) {
+                size_t nova = capDefinida ? capDefinida * 2 : 64;
+                while (nova <= id) nova *= 2;
+                unsigned char *d = (unsigned char*) realloc(definida, nova);
+                if (!d) { fprintf(stderr, "Erro de memória (conversor)\n"); exit(EXIT_FAILURE); }
+                memset(d + capDefinida, 0, nova - capDefinida);
+                definida = d;
+                capDefinida = nova;
+            }
+            if (definida[id]) {
+                fprintf(stderr, "%s:%d: sala '%s' declarada duas vezes\n", caminho, numLinha, nome);
+                erro = -1;
+                break;
+            }
+            definida[id] = 1;
+            m->salas[id].pista = internarString(m->strings, pista);
+            uint32_t e = (esq && esq[0]) ? salaPorNome(m, &nomes, esq) : SALA_NENHUMA;
+            uint32_t d = (dir && dir[0]) ? salaPorNome(m, &nomes, dir) : SALA_NENHUMA;
+            conectarSalas(m, id, e, d);
+        } else if (strcmp(tipo, "pista") == 0) {
+            char *pista = proximoCampo(&cursor);
+            char *suspeito = proximoCampo(&cursor);
+            if (!pista || !suspeito || pista[0] == '\0' || suspeito[0] == '\0') {
+                fprintf(stderr, "%s:%d: associação incompleta\n", caminho, numLinha);
+                erro = -1;
+                break;
+            }
+            inserirNaHash(ht, pista, suspeito);
+        } else if (strcmp(tipo, "passagem") == 0) {
+            char *a = proximoCampo(&cursor);
+            char *b = proximoCampo(&cursor);
+            if (!a || !b || a[0] == '\0' || b[0] == '\0') {
+                fprintf(stderr, "%s:%d: passagem incompleta\n", caminho, numLinha);
+                erro = -1;
+                break;
+            }
+            uint32_t sa = salaPorNome(m, &nomes, a);
+            conectarPassagem(m, sa, salaPorNome(m, &nomes, b));
+        } else {
+            fprintf(stderr, "%s:%d: registro desconhecido '%s'\n", caminho, numLinha, tipo);
+            erro = -1;
+        }
+    }
+    fclose(f);
+
+    for (uint32_t i = 0; !erro && i < m->qtd; ++i) {
+        if (i >= capDefinida || !definida[i]) {
+            fprintf(stderr, "%s: sala '%s' usada como caminho mas não declarada\n",
+                    caminho, texto(m->strings, m->salas[i].nome));
+            erro = -1;
+        }
+    }
+    if (!erro && m->qtd == 0) {
+        fprintf(stderr, "%s: nenhuma sala declarada\n", caminho);
+        erro = -1;
+    }
+    free(definida);
+    liberarSimbolos(&nomes);
+    if (!erro) indexarMansao(m);
+    return erro;
+}
+
+/* converterMansaoTexto: descrição em texto -> arquivo binário */
+int converterMansaoTexto(const char *entrada, const char *saida) {
+    PoolStrings strings;
+    inicializarPool(&strings);
+    Mansao m;
+    inicializarMansao(&m, &strings);
+    HashTable ht;
+    inicializarHash(&ht, &strings);
+
+    int erro = carregarMansaoTexto(entrada, &m, &ht);
+    if (!erro) erro = salvarMansaoBinaria(&m, &ht, saida);
+    if (!erro) printf("%s: %u salas, %zu associações, %zu bytes de texto\n",
+                      saida, m.qtd, ht.qtd + ht.qtdExtras, strings.usado);
+
+    liberarMansao(&m);
+    liberarHash(&ht);
+    liberarPool(&strings);
+    return erro;
+}
+
+/* -------------------- Sessão: gravar e retomar a investigação -------------------- */
+
+/* somaVerificacao: acumula 'tam' bytes em 'h', 8 por vez (mistura de 64 bits);
+   detecta arquivo truncado ou corrompido, não é proteção criptográfica */
+static uint64_t somaVerificacao(uint64_t h, const void *dados, size_t tam) {
+    const unsigned char *p = (const unsigned char*) dados;
+    uint64_t acc = h ^ (tam * 0x9E3779B97F4A7C15ULL);
+    for (; tam >= 8; p += 8, tam -= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        acc = (acc ^ w) * 0xFF51AFD7ED558CCDULL;
+        acc ^= acc >> 32;
+    }
+    uint64_t resto = 0;
+    if (tam) memcpy(&resto, p, tam);
+    return misturar64(acc ^ resto);
+}
+
+/* somaDoMapa: impressão digital das salas e passagens (StrId e ligações) */
+static uint64_t somaDoMapa(const Mansao *m) {
+    uint64_t h = somaVerificacao(0, m->salas, (size_t) m->qtd * sizeof(Sala));
+    return somaVerificacao(h, m->passagens, (size_t) m->qtdPassagens * sizeof(Passagem));
+}
+
+/* gravarSecao: grava um bloco e o inclui na soma de verificação */
+static int gravarSecao(FILE *f, uint64_t *soma, const void *p, size_t tam) {
+    *soma = somaVerificacao(*soma, p, tam);
+    return gravarBloco(f, p, tam);
+}
+
+/* salvarSessao: grava a sessão numa passada (seção por seção, cabeçalho por
+   último com a soma); as pistas saem em ordem pelo percurso iterativo da BST */
+int salvarSessao(const char *caminho, const Mansao *m, const HashTable *ht,
+                 const Investigacao *inv, const Navegacao *nav) {
+    if (m->strings != ht->strings) {
+        fprintf(stderr, "Erro: mapa e hash precisam compartilhar o mesmo pool de strings.\n");
+        return -1;
+    }
+    FILE *f = fopen(caminho, "wb");
+    if (!f) { perror(caminho); return -1; }
+
+    CabecalhoSessao cab;
+    memset(&cab, 0, sizeof cab);
+    memcpy(cab.magica, SESSAO_MAGICA, 4);
+    cab.versao = SESSAO_VERSAO;
+    cab.somaMapa = somaDoMapa(m);
+    cab.qtdSalas = m->qtd;
+    cab.atual = nav->atual;
+    cab.topo = nav->topo;
+    cab.qtdFrente = nav->qtdFrente;
+    cab.qtdPistas = inv->pistasDistintas;
+    cab.qtdAssoc = ht->qtd;
+    cab.qtdExtras = ht->qtdExtras;
+    cab.qtdSuspeitos = ht->suspeitos.qtd;
+    cab.qtdRanking = inv->qtdRanking;
+    cab.tamStrings = m->strings->usado;
+
+    /* cabeçalho provisório: reescrito no fim, quando a soma é conhecida */
+    uint64_t soma = 0;
+    int erro = gravarBloco(f, &cab, sizeof cab) ||
+               gravarSecao(f, &soma, nav->pilha, nav->topo * sizeof(uint32_t)) ||
+               gravarSecao(f, &soma, nav->frente, nav->qtdFrente * sizeof(uint32_t));
+
+    /* pistas em ordem, em lotes (a soma é por bloco, então o lote é fixo) */
+    PistaSessao lote[1024];
+    size_t qtdLote = 0, gravadas = 0;
+    const BSTNode *pilha[BST_ALTURA_MAX];
+    int topo = 0;
+    const BSTNode *n = inv->raizPistas;
+    while (!erro && (n || topo > 0)) {
+        for (; n; n = n->esq) pilha[topo++] = n; /* altura limitada por BST_ALTURA_MAX na inserção */
+        n = pilha[--topo];
+        PistaSessao p = { n->pista, n->contador, n->suspeito };
+        lote[qtdLote++] = p;
+        gravadas++;
+        if (qtdLote == sizeof lote / sizeof lote[0]) {
+            erro = gravarSecao(f, &soma, lote, sizeof lote);
+            qtdLote = 0;
+        }
+        n = n->dir;
+    }
+    if (!erro && qtdLote) erro = gravarSecao(f, &soma, lote, qtdLote * sizeof lote[0]);
+    if (gravadas != inv->pistasDistintas) erro = -1;
+
+    if (!erro) {
+        AssocArquivo *assoc = ordenarAssociacoes(ht);
+        erro = gravarSecao(f, &soma, assoc, ht->qtd * sizeof(AssocArquivo));
+        free(assoc);
+    }
+    if (!erro) {
+        AssocArquivo *extras = listarAssociacoesExtras(ht);
+        erro = gravarSecao(f, &soma, extras, ht->qtdExtras * sizeof(AssocArquivo));
+        free(extras);
+    }
+    /* todos os suspeitos internados, inclusive os que perderam associações:
+       os ids guardados nas pistas e no ranking continuam valendo */
+    if (!erro) erro = gravarSecao(f, &soma, ht->suspeitos.nomes, ht->suspeitos.qtd * sizeof(StrId));
+    if (!erro) erro = gravarSecao(f, &soma, inv->ranking, inv->qtdRanking * sizeof(int));
+    if (!erro && inv->qtdRanking) {
+        int32_t *cont = (int32_t*) malloc(inv->qtdRanking * sizeof(int32_t));
+        if (!cont) { fprintf(stderr, "Erro de memória (sessão)\n"); exit(EXIT_FAILURE); }
+        for (size_t k = 0; k < inv->qtdRanking; ++k) cont[k] = inv->pistasPorSuspeito[inv->ranking[k]];
+        erro = gravarSecao(f, &soma, cont, inv->qtdRanking * sizeof(int32_t));
+        free(cont);
+    }
+    if (!erro) erro = gravarSecao(f, &soma, m->strings->dados, m->strings->usado);
+
+    cab.soma = soma;
+    if (!erro) erro = fseek(f, 0, SEEK_SET) != 0 || gravarBloco(f, &cab, sizeof cab);
+    if (fclose(f) != 0) erro = -1;
+    if (erro) fprintf(stderr, "Erro ao gravar %s\n", caminho);
+    return erro ? -1 : 0;
+}
+
+/* restaurarHistorico: copia uma pilha de salas do arquivo para a navegação */
+static uint32_t* restaurarHistorico(uint32_t *v, size_t *cap, const uint32_t *origem, size_t qtd) {
+    while (*cap < qtd) v = crescerHistorico(v, cap);
+    if (qtd) memcpy(v, origem, qtd * sizeof(uint32_t));
+    return v;
+}
+
+/* carregarSessao: mapeia o arquivo, valida tudo (soma, mapa, referências,
+   ordem das pistas, ranking sem repetidos) e só então substitui pool, hash,
+   investigação e navegação. Os nós da BST vêm de uma única alocação na arena. */
+int carregarSessao(const char *caminho, const Mansao *m, HashTable *ht,
+                   Investigacao *inv, Navegacao *nav) {
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) { perror(caminho); return -1; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(CabecalhoSessao)) {
+        fprintf(stderr, "Erro: %s não é um arquivo de sessão válido.\n", caminho);
+        close(fd);
+        return -1;
+    }
+    size_t tam = (size_t) st.st_size;
+    void *mapa = mmap(NULL, tam, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED) { perror("mmap"); return -1; }
+
+    const unsigned char *base = (const unsigned char*) mapa;
+    const CabecalhoSessao *cab = (const CabecalhoSessao*) base;
+    const char *motivo = NULL;
+    uint64_t resto = tam - sizeof *cab;
+    if (memcmp(cab->magica, SESSAO_MAGICA, 4) != 0) motivo = "assinatura inválida";
+    else if (cab->versao != SESSAO_VERSAO) motivo = "versão não suportada";
+    else if (cab->qtdSalas != m->qtd || cab->somaMapa != somaDoMapa(m)) motivo = "sessão gravada com outro mapa";
+    else if (cab->topo > m->qtd || cab->qtdFrente > m->qtd || cab->atual >= m->qtd ||
+             cab->qtdPistas > resto / sizeof(PistaSessao) || cab->qtdAssoc > resto / sizeof(AssocArquivo) ||
+             cab->qtdExtras > resto / sizeof(AssocArquivo) ||
+             cab->qtdSuspeitos > resto / sizeof(StrId) || cab->qtdSuspeitos > INT32_MAX ||
+             cab->qtdRanking > resto / (2 * sizeof(int32_t)) || cab->tamStrings == 0 ||
+             cab->tamStrings > UINT32_MAX ||
+             (cab->topo + cab->qtdFrente) * sizeof(uint32_t) + cab->qtdPistas * sizeof(PistaSessao) +
+             (cab->qtdAssoc + cab->qtdExtras) * sizeof(AssocArquivo) + cab->qtdSuspeitos * sizeof(StrId) +
+             cab->qtdRanking * 2 * sizeof(int32_t) +
+             cab->tamStrings != resto)
+        motivo = "tamanho das seções não confere";
+
+    /* seções, na ordem do arquivo */
+    const uint32_t *pilha = (const uint32_t*) (base + sizeof *cab);
+    const uint32_t *frente = pilha + (motivo ? 0 : cab->topo);
+    const PistaSessao *pistas = (const PistaSessao*) (frente + (motivo ? 0 : cab->qtdFrente));
+    const AssocArquivo *assoc = (const AssocArquivo*) (pistas + (motivo ? 0 : cab->qtdPistas));
+    const AssocArquivo *extras = assoc + (motivo ? 0 : cab->qtdAssoc);
+    const StrId *suspeitos = (const StrId*) (extras + (motivo ? 0 : cab->qtdExtras));
+    const int32_t *ranking = (const int32_t*) (suspeitos + (motivo ? 0 : cab->qtdSuspeitos));
+    const int32_t *contagens = ranking + (motivo ? 0 : cab->qtdRanking);
+    const char *strings = (const char*) (contagens + (motivo ? 0 : cab->qtdRanking));
+    if (!motivo) {
+        uint64_t soma = 0;
+        soma = somaVerificacao(soma, pilha, cab->topo * sizeof(uint32_t));
+        soma = somaVerificacao(soma, frente, cab->qtdFrente * sizeof(uint32_t));
+        size_t lote = 1024; /* mesmos blocos da gravação */
+        for (size_t k = 0; k < cab->qtdPistas; k += lote)
+            soma = somaVerificacao(soma, pistas + k,
+                                   (cab->qtdPistas - k < lote ? cab->qtdPistas - k : lote) * sizeof(PistaSessao));
+        soma = somaVerificacao(soma, assoc, cab->qtdAssoc * sizeof(AssocArquivo));
+        soma = somaVerificacao(soma, extras, cab->qtdExtras * sizeof(AssocArquivo));
+        soma = somaVerificacao(soma, suspeitos, cab->qtdSuspeitos * sizeof(StrId));
+        soma = somaVerificacao(soma, ranking, cab->qtdRanking * sizeof(int32_t));
+        soma = somaVerificacao(soma, contagens, cab->qtdRanking * sizeof(int32_t));
+        soma = somaVerificacao(soma, strings, cab->tamStrings);
+        if (soma != cab->soma) motivo = "soma de verificação não confere (arquivo corrompido)";
+    }
+    if (!motivo && (strings[0] != '\0' || strings[cab->tamStrings - 1] != '\0'))
+        motivo = "tabela de strings mal terminada";
+    /* as salas do mapa têm de apontar para os mesmos textos no pool gravado */
+    for (uint32_t i = 0; !motivo && i < m->qtd; ++i) {
+        const Sala *s = &m->salas[i];
+        if (s->nome >= cab->tamStrings || s->pista >= cab->tamStrings ||
+            strcmp(strings + s->nome, texto(m->strings, s->nome)) != 0 ||
+            strcmp(strings + s->pista, texto(m->strings, s->pista)) != 0)
+            motivo = "textos do mapa não conferem";
+    }
+    for (size_t k = 0; !motivo && k < cab->topo + cab->qtdFrente; ++k)
+        if (pilha[k] >= m->qtd) motivo = "histórico com sala inválida"; /* frente segue a pilha */
+    for (size_t k = 0; !motivo && k < cab->qtdAssoc + cab->qtdExtras; ++k) /* extras seguem as principais */
+        if (assoc[k].pista >= cab->tamStrings || assoc[k].suspeito >= cab->tamStrings)
+            motivo = "associação com referência inválida";
+    for (size_t k = 0; !motivo && k < cab->qtdSuspeitos; ++k)
+        if (suspeitos[k] == 0 || suspeitos[k] >= cab->tamStrings) motivo = "suspeito com referência inválida";
+    /* tabela de suspeitos montada à parte: só é adotada se os ids conferirem */
+    TabelaSimbolos tabSuspeitos;
+    memset(&tabSuspeitos, 0, sizeof tabSuspeitos);
+    for (size_t k = 0; !motivo && k < cab->qtdSuspeitos; ++k)
+        if ((size_t) internarSimbolo(&tabSuspeitos, suspeitos[k]) != k) motivo = "suspeito repetido";
+    size_t qtdSuspeitos = motivo ? 0 : cab->qtdSuspeitos;
+    for (size_t k = 0; !motivo && k < cab->qtdPistas; ++k) {
+        const PistaSessao *p = &pistas[k];
+        if (p->pista == 0 || p->pista >= cab->tamStrings || p->contador <= 0 ||
+            p->suspeito < -1 || p->suspeito >= (int64_t) qtdSuspeitos)
+            motivo = "pista com referência inválida";
+        else if (k > 0 && strcmp(strings + pistas[k - 1].pista, strings + p->pista) >= 0)
+            motivo = "pistas fora de ordem";
+    }
+    if (!motivo && cab->qtdRanking > qtdSuspeitos) motivo = "ranking inválido";
+    unsigned char *visto = motivo ? NULL : calloc(qtdSuspeitos / 8 + 1, 1); /* um bit por suspeito */
+    if (!motivo && !visto) { fprintf(stderr, "Erro de memória (sessão)\n"); exit(EXIT_FAILURE); }
+    for (size_t k = 0; !motivo && k < cab->qtdRanking; ++k) {
+        if (ranking[k] < 0 || ranking[k] >= (int64_t) qtdSuspeitos || contagens[k] <= 0 ||
+            (k > 0 && contagens[k] > contagens[k - 1]))
+            motivo = "ranking inválido";
+        else if (visto[ranking[k] / 8] & (1u << (ranking[k] % 8)))
+            motivo = "suspeito repetido no ranking";
+        else
+            visto[ranking[k] / 8] |= (unsigned char) (1u << (ranking[k] % 8));
+    }
+    free(visto);
+    if (motivo) {
+        fprintf(stderr, "Erro: %s: %s.\n", caminho, motivo);
+        liberarSimbolos(&tabSuspeitos);
+        munmap(mapa, tam);
+        return -1;
+    }
+
+    /* pool: a cópia gravada contém os textos do mapa nos mesmos deslocamentos */
+    PoolStrings *ps = m->strings;
+    char *dados = (char*) malloc(cab->tamStrings);
+    ESTAT_ALOC(EST_POOL, cab->tamStrings);
+    if (!dados) { fprintf(stderr, "Erro de memória (sessão)\n"); exit(EXIT_FAILURE); }
+    memcpy(dados, strings, cab->tamStrings);
+    liberarPool(ps);
+    ps->dados = dados;
+    ps->usado = ps->cap = cab->tamStrings; /* índice refeito na primeira busca */
+
+    /* hash: tabela de suspeitos com os ids gravados, depois as associações */
+    liberarHash(ht);
+    inicializarHash(ht, ps);
+    ht->suspeitos = tabSuspeitos;
+    reservarHash(ht, cab->qtdAssoc);
+    for (size_t k = 0; k < cab->qtdAssoc; ++k) inserirNaHashStr(ht, assoc[k].pista, assoc[k].suspeito);
+    for (size_t k = 0; k < cab->qtdExtras; ++k) acrescentarSuspeitoStr(ht, extras[k].pista, extras[k].suspeito);
+
+    /* investigação: nós contíguos em ordem, árvore montada pelo meio */
+    reiniciarInvestigacao(inv);
+    if (cab->qtdPistas) {
+        BSTNode *nos = (BSTNode*) arenaAlocar(&inv->arena, cab->qtdPistas * sizeof(BSTNode));
+        for (size_t k = 0; k < cab->qtdPistas; ++k) {
+            nos[k].pista = pistas[k].pista;
+            nos[k].contador = pistas[k].contador;
+            nos[k].suspeito = pistas[k].suspeito;
+        }
+        inv->raizPistas = montarBalanceada(nos, cab->qtdPistas);
+    }
+    inv->pistasDistintas = cab->qtdPistas;
+    /* contagens refeitas das pistas restauradas (contador x cada suspeito da
+       lista, como na coleta), não copiadas do arquivo; o ranking gravado só
+       decide a ordem dos empates, e os demais citados entram por id */
+    if (ht->suspeitos.qtd > inv->capSuspeitos) crescerSuspeitos(inv, (int) ht->suspeitos.qtd - 1);
+    int *total = calloc(inv->capSuspeitos + 1, sizeof(int));
+    if (!total) { fprintf(stderr, "Erro de memória (sessão)\n"); exit(EXIT_FAILURE); }
+    for (size_t k = 0; k < cab->qtdPistas; ++k) {
+        const HashEntry *e = buscarEntradaStr(ht, pistas[k].pista, hashChave(texto(ps, pistas[k].pista)));
+        CursorSuspeitos c;
+        if (e) abrirSuspeitos(ht, e, &c);
+        for (int s; e && (s = proximoSuspeito(&c)) >= 0; )
+            total[s] = total[s] > INT_MAX - pistas[k].contador ? INT_MAX : total[s] + pistas[k].contador;
+    }
+    for (size_t k = 0; k < cab->qtdRanking; ++k)
+        if (total[ranking[k]] > 0) { somarNoRanking(inv, ranking[k], total[ranking[k]]); total[ranking[k]] = 0; }
+    for (size_t s = 0; s < inv->capSuspeitos; ++s)
+        if (total[s] > 0) somarNoRanking(inv, (int) s, total[s]);
+    free(total);
+
+    /* navegação: pilha, frente e índice de posições */
+    reiniciarNavegacao(nav);
+    nav->pilha = restaurarHistorico(nav->pilha, &nav->capPilha, pilha, cab->topo);
+    nav->frente = restaurarHistorico(nav->frente, &nav->capFrente, frente, cab->qtdFrente);
+    nav->topo = cab->topo;
+    nav->qtdFrente = cab->qtdFrente;
+    for (size_t k = 0; k < nav->topo; ++k) nav->posicao[nav->pilha[k]] = (uint32_t) (k + 1);
+    nav->atual = cab->atual;
+
+    munmap(mapa, tam);
+    return 0;
+}
+
+/* -------------------- Arquivo de caso (CSV) -------------------- */
+
+/* separarCampoCSV: isola o campo que começa em *p (dentro de [*p, fim)), tratando
+   aspas ("" dentro de aspas vira "); termina o campo com '\0' no próprio buffer */
+static char* separarCampoCSV(char **p, char *fim, char sep) {
+    char *ini = *p;
+    if (ini < fim && *ini == '"') {
+        char *r = ini + 1, *w = ini;
+        while (r < fim) {
+            if (*r == '"') {
+                if (r + 1 < fim && r[1] == '"') { *w++ = '"'; r += 2; continue; }
+                r++;
+                break;
+            }
+            *w++ = *r++;
+        }
+        while (r < fim && *r != sep) r++;
+        *w = '\0';
+        *p = (r < fim) ? r + 1 : fim;
+        return ini;
+    }
+    char *r = ini;
+    while (r < fim && *r != sep) r++;
+    *r = '\0';                       /* r < fim ou r == fim (terminador reservado) */
+    *p = (r < fim) ? r + 1 : fim;
+    return ini;
+}
+
+/* picoMemoriaKB: pico de memória residente do processo (getrusage) */
+static long picoMemoriaKB(void) {
+    struct rusage uso;
+    if (getrusage(RUSAGE_SELF, &uso) != 0) return -1;
+    return uso.ru_maxrss;            /* Linux: KiB */
+}
+
+/* carregarCasoCSV: lê o arquivo em blocos de CSV_BUFFER bytes e insere cada linha
+   "pista<sep>suspeito" na hash. Os campos são separados no próprio buffer (sem
+   alocação por linha). A hash e o pool são pré-dimensionados a partir de
+   'dicaLinhas' (ou, se 0, do tamanho do arquivo / tamanho médio das linhas do
+   primeiro bloco). Uma primeira linha "pista<sep>suspeito" é tratada como cabeçalho.
+   Uma 3ª coluna opcional é o peso da evidência (> 0; padrão 1): com 'ev', toda
+   linha vira também uma tripla. Na hash, a pista guarda todos os suspeitos das
+   suas linhas; o da última linha fica como principal. */
+int carregarCasoCSV(HashTable *ht, const char *caminho, size_t dicaLinhas, RelatorioCarga *rel,
+                    MatrizEvidencias *ev) {
+    memset(rel, 0, sizeof *rel);
+    FILE *f = fopen(caminho, "rb");
+    if (!f) { perror(caminho); return -1; }
+    struct stat st;
+    size_t tamArquivo = (fstat(fileno(f), &st) == 0) ? (size_t) st.st_size : 0;
+
+    char *buf = (char*) malloc(CSV_BUFFER + 1);   /* +1: terminador da última linha sem '\n' */
+    if (!buf) { fprintf(stderr, "Erro de memória (caso)\n"); exit(EXIT_FAILURE); }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    size_t pendente = 0;       /* bytes de uma linha incompleta no início do buffer */
+    int primeiroBloco = 1, fimArquivo = 0, erro = 0;
+    char sep = ';';
+    size_t numLinha = 0;
+
+    while (!fimArquivo) {
+        size_t lidos = fread(buf + pendente, 1, CSV_BUFFER - pendente, f);
+        if (lidos < CSV_BUFFER - pendente) {
+            if (ferror(f)) { perror(caminho); erro = -1; break; }
+            fimArquivo = 1;
+        }
+        size_t total = pendente + lidos;
+        char *fimDados = buf + total;
+
+        /* sem fim de arquivo, só processa até o último '\n' do bloco */
+        char *fimUtil = fimDados;
+        if (!fimArquivo) {
+            while (fimUtil > buf && fimUtil[-1] != '\n') fimUtil--;
+            if (fimUtil == buf) {
+                fprintf(stderr, "%s: linha maior que %d bytes\n", caminho, CSV_BUFFER);
+                erro = -1;
+                break;
+            }
+        }
+
+        if (primeiroBloco) {
+            /* separador: o primeiro entre ';', tab e ',' presente na primeira linha */
+            char *nl = memchr(buf, '\n', (size_t) (fimUtil - buf));
+            size_t lenLinha = nl ? (size_t) (nl - buf) : (size_t) (fimUtil - buf);
+            if (memchr(buf, ';', lenLinha)) sep = ';';
+            else if (memchr(buf, '\t', lenLinha)) sep = '\t';
+            else if (memchr(buf, ',', lenLinha)) sep = ',';
+            if (dicaLinhas == 0 && tamArquivo > 0) {
+                size_t linhasBloco = 0;
+                for (char *c = buf; c < fimUtil; ++c) linhasBloco += (*c == '\n');
+                if (linhasBloco) dicaLinhas = tamArquivo / ((size_t) (fimUtil - buf) / linhasBloco) + 1;
+            }
+            if (dicaLinhas) {
+                reservarHash(ht, ht->qtd + dicaLinhas);
+                reservarPool(ht->strings, tamArquivo, dicaLinhas);
+            }
+            primeiroBloco = 0;
+        }
+
+        char *p = buf;
+        while (p < fimUtil) {
+            char *nl = memchr(p, '\n', (size_t) (fimUtil - p));
+            char *fimLinha = nl ? nl : fimUtil;
+            char *proxima = nl ? nl + 1 : fimUtil;
+            if (fimLinha > p && fimLinha[-1] == '\r') fimLinha--;
+            numLinha++;
+
+            char *c = p;
+            char *pista = separarCampoCSV(&c, fimLinha, sep);
+            char *suspeito = (c < fimLinha) ? separarCampoCSV(&c, fimLinha, sep) : NULL;
+            char *campoPeso = (c < fimLinha) ? separarCampoCSV(&c, fimLinha, sep) : NULL;
+            double peso = 1.0;
+            char *fimPeso = NULL;
+            if (campoPeso && campoPeso[0] != '\0') peso = strtod(campoPeso, &fimPeso);
+            if (!suspeito || pista[0] == '\0' || suspeito[0] == '\0' ||
+                (fimPeso && (*fimPeso != '\0' || !(peso > 0.0))) ||
+                (numLinha == 1 && strcmp(pista, "pista") == 0 && strcmp(suspeito, "suspeito") == 0)) {
+                rel->ignoradas++;
+            } else {
+                StrId p = internarString(ht->strings, pista);
+                StrId sus = internarString(ht->strings, suspeito);
+                inserirNaHashStr(ht, p, sus);
+                if (ev) adicionarEvidencia(ev, ht, p, sus, (float) peso);
+                rel->linhas++;
+            }
+            p = proxima;
+        }
+
+        pendente = (size_t) (fimDados - fimUtil);
+        memmove(buf, fimUtil, pendente);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    rel->segundos = (double) (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    rel->picoMemoriaKB = picoMemoriaKB();
+    free(buf);
+    fclose(f);
+    return erro;
+}
+
+/* montarMansaoPadrao: mapa e associações fixos do jogo */
+void montarMansaoPadrao(Mansao *m, HashTable *ht) {
+    /* Montagem do mapa (árvore de salas) */
+    uint32_t hall = criarSala(m, "Hall de Entrada", "pegada barro fora da porta");
+    uint32_t salaEstar = criarSala(m, "Sala de Estar", "xícara quebrada");
+    uint32_t cozinha = criarSala(m, "Cozinha", "faca limpa no balcão");
+    uint32_t biblioteca = criarSala(m, "Biblioteca", "página arrancada do diário");
+    uint32_t jardim = criarSala(m, "Jardim", "fio de cabelo loiro");
+    uint32_t escritorio = criarSala(m, "Escritório", "bilhete com ameaça");
+    uint32_t porao = criarSala(m, "Porão", "pegada barro fora da porta"); /* mesma pista do hall */
+    uint32_t quarto = criarSala(m, "Quarto Principal", "anel com inicial gravada");
+    uint32_t lavat = criarSala(m, "Lavabo", "mancha de tinta azul");
+
+    /* Conexões (exemplo): */
+    conectarSalas(m, hall, salaEstar, cozinha);
+    conectarSalas(m, salaEstar, biblioteca, jardim);
+    conectarSalas(m, cozinha, SALA_NENHUMA, escritorio);
+    conectarSalas(m, escritorio, SALA_NENHUMA, porao);
+    conectarSalas(m, biblioteca, quarto, lavat);
+    indexarMansao(m);
+
+    /* Inserir associações pista -> suspeito na hash (dados fixos) */
+    inserirNaHash(ht, "pegada barro fora da porta", "Sr. Morais");
+    inserirNaHash(ht, "xícara quebrada", "Sra. Duarte");
+    inserirNaHash(ht, "faca limpa no balcão", "Chef Marco");
+    inserirNaHash(ht, "página arrancada do diário", "Sra. Duarte");
+    inserirNaHash(ht, "fio de cabelo loiro", "Jovem Lia");
+    inserirNaHash(ht, "bilhete com ameaça", "Sr. Morais");
+    inserirNaHash(ht, "anel com inicial gravada", "Condessa");
+    inserirNaHash(ht, "mancha de tinta azul", "Pintor Raul");
+}
+
+/* -------------------- Gerador de mansões (testes de escala) -------------------- */
+
+enum { GER_SEM_PISTA, GER_ORIGINAL, GER_REPETIDA };
+
+/* sorteioSala: número pseudoaleatório que depende só de semente, sala e canal */
+static uint64_t sorteioSala(uint64_t semente, uint64_t sala, unsigned canal) {
+    return misturar64(semente ^ misturar64(sala * 16 + canal));
+}
+
+/* sorteioAbaixo: verdadeiro com probabilidade 'prob' (53 bits do sorteio) */
+static int sorteioAbaixo(uint64_t x, double prob) {
+    return (double) (x >> 11) * (1.0 / 9007199254740992.0) < prob;
+}
+
+/* pistaGerada: sem pista, pista própria ou repetição da pista de 'origem'.
+   A origem é sorteada entre salas anteriores cuja pista é própria por sorteio
+   (sem consultar a origem dela), então a decisão não tem cadeia: cada sala
+   é classificada isoladamente. Sem origem em GER_TENTATIVAS, a pista é própria. */
+static int pistaGerada(const ParametrosGerador *p, uint32_t i, uint32_t *origem) {
+    if (!sorteioAbaixo(sorteioSala(p->semente, i, 0), p->densidade)) return GER_SEM_PISTA;
+    if (i == 0 || !sorteioAbaixo(sorteioSala(p->semente, i, 1), p->repetidas)) return GER_ORIGINAL;
+    for (unsigned t = 0; t < GER_TENTATIVAS; ++t) {
+        uint32_t j = (uint32_t) (sorteioSala(p->semente, i, 2 + t) % i);
+        if (sorteioAbaixo(sorteioSala(p->semente, j, 0), p->densidade) &&
+            (j == 0 || !sorteioAbaixo(sorteioSala(p->semente, j, 1), p->repetidas))) {
+            *origem = j;
+            return GER_REPETIDA;
+        }
+    }
+    return GER_ORIGINAL;
+}
+
+/* tamTextoNumerado / escreverTextoNumerado: "<prefixo><n>\0" sem snprintf */
+static size_t tamTextoNumerado(size_t tamPrefixo, uint32_t n) {
+    size_t d = 1;
+    for (; n >= 10; n /= 10) d++;
+    return tamPrefixo + d + 1;
+}
+
+static size_t escreverTextoNumerado(char *dst, const char *prefixo, size_t tamPrefixo, uint32_t n) {
+    char dig[10];
+    size_t d = 0;
+    do { dig[d++] = (char) ('0' + n % 10); n /= 10; } while (n);
+    memcpy(dst, prefixo, tamPrefixo);
+    for (size_t k = 0; k < d; ++k) dst[tamPrefixo + k] = dig[d - 1 - k];
+    dst[tamPrefixo + d] = '\0';
+    return tamPrefixo + d + 1;
+}
+
+/* Faixa de salas [ini, ini + tam) que forma uma subárvore na forma aleatória */
+typedef struct {
+    uint32_t ini, tam;
+} FaixaArvore;
+
+/* Fatia de trabalho de uma thread do gerador */
+typedef struct {
+    const ParametrosGerador *p;
+    Mansao *m;
+    uint32_t inicio, fim;       /* salas [inicio, fim) */
+    size_t bytes;               /* fase de contagem: texto da fatia */
+    size_t deslocamento;        /* fase de escrita: onde a fatia começa no pool */
+    const FaixaArvore *tarefas; /* forma aleatória: subárvores desta thread (passo 'salto') */
+    size_t qtdTarefas, primeira, salto;
+    int fase;
+} TrabalhoGerador;
+
+enum { GER_FASE_CONTAR, GER_FASE_ESCREVER, GER_FASE_LIGAR };
+
+/* crescerFaixas: dobra um vetor de faixas */
+static FaixaArvore* crescerFaixas(FaixaArvore *v, size_t *cap) {
+    FaixaArvore *d = (FaixaArvore*) realloc(v, *cap * 2 * sizeof(FaixaArvore));
+    if (!d) { fprintf(stderr, "Erro de memória (gerador)\n"); exit(EXIT_FAILURE); }
+    *cap *= 2;
+    return d;
+}
+
+/* dividirFaixa: raiz em 'ini', tamanho da esquerda sorteado; liga os filhos */
+static void dividirFaixa(const ParametrosGerador *p, Sala *salas, FaixaArvore f,
+                         FaixaArvore *esq, FaixaArvore *dir) {
+    uint32_t tamEsq = (uint32_t) (sorteioSala(p->semente, f.ini, 12) % f.tam);
+    esq->ini = f.ini + 1;
+    esq->tam = tamEsq;
+    dir->ini = f.ini + 1 + tamEsq;
+    dir->tam = f.tam - 1 - tamEsq;
+    salas[f.ini].esquerda = esq->tam ? esq->ini : SALA_NENHUMA;
+    salas[f.ini].direita = dir->tam ? dir->ini : SALA_NENHUMA;
+}
+
+/* ligarSubarvore: segue pela metade menor e empilha a maior, então a pilha
+   não passa de log2(salas) entradas mesmo em divisões desequilibradas */
+static void ligarSubarvore(const ParametrosGerador *p, Sala *salas, FaixaArvore f) {
+    FaixaArvore pilha[64];
+    int topo = 0;
+    for (;;) {
+        if (f.tam > 0) {
+            FaixaArvore esq, dir;
+            dividirFaixa(p, salas, f, &esq, &dir);
+            if (esq.tam < dir.tam) { pilha[topo++] = dir; f = esq; }
+            else { pilha[topo++] = esq; f = dir; }
+            continue;
+        }
+        if (topo == 0) break;
+        f = pilha[--topo];
+    }
+}
+
+/* executarFaseGerador: corpo das threads; cada fase só escreve na própria fatia
+   (ou nas próprias subárvores) */
+static void* executarFaseGerador(void *arg) {
+    TrabalhoGerador *t = arg;
+    const ParametrosGerador *p = t->p;
+    Sala *salas = t->m->salas;
+    char *dados = t->m->strings->dados;
+    uint32_t origem;
+
+    if (t->fase == GER_FASE_CONTAR) {
+        size_t bytes = 0;
+        for (uint32_t i = t->inicio; i < t->fim; ++i) {
+            bytes += tamTextoNumerado(5, i);
+            if (pistaGerada(p, i, &origem) == GER_ORIGINAL) bytes += tamTextoNumerado(6, i);
+        }
+        t->bytes = bytes;
+    } else if (t->fase == GER_FASE_ESCREVER) {
+        size_t off = t->deslocamento;
+        for (uint32_t i = t->inicio; i < t->fim; ++i) {
+            Sala *s = &salas[i];
+            s->nome = (StrId) off;
+            off += escreverTextoNumerado(dados + off, "Sala ", 5, i);
+            s->pista = 0;
+            if (pistaGerada(p, i, &origem) == GER_ORIGINAL) {
+                s->pista = (StrId) off;
+                off += escreverTextoNumerado(dados + off, "pista ", 6, i);
+            }
+            if (p->forma == FORMA_BALANCEADA) {
+                uint64_t e = 2 * (uint64_t) i + 1;
+                s->esquerda = e < p->salas ? (uint32_t) e : SALA_NENHUMA;
+                s->direita = e + 1 < p->salas ? (uint32_t) (e + 1) : SALA_NENHUMA;
+            } else {
+                uint32_t prox = i + 1 < p->salas ? i + 1 : SALA_NENHUMA;
+                s->esquerda = p->forma == FORMA_CADEIA_ESQUERDA ? prox : SALA_NENHUMA;
+                s->direita = p->forma == FORMA_CADEIA_DIREITA ? prox : SALA_NENHUMA;
+            }
+        }
+    } else {
+        /* repetidas leem a pista da origem, escrita (e nunca alterada) na fase anterior */
+        for (uint32_t i = t->inicio; i < t->fim; ++i)
+            if (pistaGerada(p, i, &origem) == GER_REPETIDA) salas[i].pista = salas[origem].pista;
+        for (size_t k = t->primeira; k < t->qtdTarefas; k += t->salto)
+            ligarSubarvore(p, salas, t->tarefas[k]);
+    }
+    return NULL;
+}
+
+/* executarFaseEmParalelo: uma thread por fatia; fatia cuja thread não pôde
+   ser criada é executada aqui mesmo (o resultado não muda) */
+static void executarFaseEmParalelo(TrabalhoGerador *trab, unsigned n, int fase) {
+    pthread_t ids[SIM_THREADS_MAX];
+    int criada[SIM_THREADS_MAX];
+    for (unsigned i = 0; i < n; ++i) {
+        trab[i].fase = fase;
+        criada[i] = i > 0 && pthread_create(&ids[i], NULL, executarFaseGerador, &trab[i]) == 0;
+    }
+    for (unsigned i = 0; i < n; ++i)
+        if (!criada[i]) executarFaseGerador(&trab[i]);
+    for (unsigned i = 0; i < n; ++i)
+        if (criada[i]) pthread_join(ids[i], NULL);
+}
+
+/* gerarMansao: monta em 'm' e 'ht' (vazios, mesmo pool) uma mansão de
+   p->salas salas. Textos ("Sala N", "pista N", "Suspeito K") são únicos por
+   construção, então vão direto para o pool, sem passar pelo índice (refeito na
+   primeira busca); salas e pool são alocados uma vez. Em paralelo: contagem
+   dos bytes por fatia, escrita nos deslocamentos da soma prefixada, e pistas
+   repetidas + forma aleatória. A hash é preenchida em seguida (sequencial).
+   Retorna 0, ou -1 se os parâmetros não cabem (pool de 4 GiB, mapa não vazio). */
+int gerarMansao(Mansao *m, HashTable *ht, const ParametrosGerador *p, RelatorioGerador *rel) {
+    PoolStrings *ps = m->strings;
+    if (m->qtd != 0 || m->mapa || ps != ht->strings || ps->cap == 0 || ht->qtd != 0 ||
+        p->salas == 0 || p->salas >= SALA_NENHUMA || p->suspeitos == 0) {
+        fprintf(stderr, "Erro: parâmetros do gerador inválidos (mapa e hash devem estar vazios).\n");
+        return -1;
+    }
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    unsigned nThreads = p->threads;
+    if (nThreads == 0) {
+        long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+        nThreads = nucleos > 0 ? (unsigned) nucleos : 1;
+    }
+    if (nThreads > SIM_THREADS_MAX) nThreads = SIM_THREADS_MAX;
+    if (nThreads > p->salas) nThreads = p->salas;
+    TrabalhoGerador *trab = (TrabalhoGerador*) calloc(nThreads, sizeof(TrabalhoGerador));
+    if (!trab) { fprintf(stderr, "Erro de memória (gerador)\n"); exit(EXIT_FAILURE); }
+    for (unsigned i = 0; i < nThreads; ++i) {
+        trab[i].p = p;
+        trab[i].m = m;
+        trab[i].inicio = (uint32_t) ((uint64_t) p->salas * i / nThreads);
+        trab[i].fim = (uint32_t) ((uint64_t) p->salas * (i + 1) / nThreads);
+    }
+    executarFaseEmParalelo(trab, nThreads, GER_FASE_CONTAR);
+
+    /* suspeitos primeiro, depois as fatias na ordem das salas */
+    size_t bytes = 0;
+    for (uint32_t k = 0; k < p->suspeitos; ++k) bytes += tamTextoNumerado(9, k);
+    size_t off = ps->usado + bytes;
+    for (unsigned i = 0; i < nThreads; ++i) { trab[i].deslocamento = off; off += trab[i].bytes; }
+    if (off > UINT32_MAX) {
+        fprintf(stderr, "Erro: textos da mansão gerada excedem o pool de 4 GiB.\n");
+        free(trab);
+        return -1;
+    }
+    if (off > ps->cap) {
+        char *d = (char*) realloc(ps->dados, off);
+        ESTAT_ALOC(EST_POOL, off);
+        if (!d) { fprintf(stderr, "Erro de memória (strings)\n"); exit(EXIT_FAILURE); }
+        ps->dados = d;
+        ps->cap = off;
+    }
+    Sala *salas = (Sala*) realloc(m->salas, (size_t) p->salas * sizeof(Sala));
+    ESTAT_ALOC(EST_MANSAO, (size_t) p->salas * sizeof(Sala));
+    if (!salas) { fprintf(stderr, "Erro: falha ao alocar memória para sala.\n"); exit(EXIT_FAILURE); }
+    m->salas = salas;
+    m->cap = m->qtd = p->salas;
+
+    StrId *suspeitos = (StrId*) malloc((size_t) p->suspeitos * sizeof(StrId));
+    if (!suspeitos) { fprintf(stderr, "Erro de memória (gerador)\n"); exit(EXIT_FAILURE); }
+    for (uint32_t k = 0; k < p->suspeitos; ++k) {
+        suspeitos[k] = (StrId) ps->usado;
+        ps->usado += escreverTextoNumerado(ps->dados + ps->usado, "Suspeito ", 9, k);
+    }
+    executarFaseEmParalelo(trab, nThreads, GER_FASE_ESCREVER);
+    ps->usado = off;
+    free(ps->indice); /* textos novos não estão no índice: refeito na primeira busca */
+    ps->indice = NULL;
+    ps->capIndice = ps->qtd = 0;
+
+    /* forma aleatória: divide as faixas do topo até haver subárvores para todas as threads */
+    FaixaArvore *tarefas = NULL;
+    size_t qtdTarefas = 0;
+    if (p->forma == FORMA_ALEATORIA) {
+        size_t limite = (size_t) p->salas / ((size_t) nThreads * GER_TAREFAS_POR_THREAD) + 1;
+        size_t capTarefas = 64, capPend = 64, qtdPend = 1;
+        tarefas = (FaixaArvore*) malloc(capTarefas * sizeof(FaixaArvore));
+        FaixaArvore *pend = (FaixaArvore*) malloc(capPend * sizeof(FaixaArvore));
+        if (!tarefas || !pend) { fprintf(stderr, "Erro de memória (gerador)\n"); exit(EXIT_FAILURE); }
+        pend[0].ini = 0;
+        pend[0].tam = p->salas;
+        while (qtdPend > 0) {
+            FaixaArvore f = pend[--qtdPend];
+            if (f.tam == 0) continue;
+            if (f.tam <= limite) {
+                if (qtdTarefas == capTarefas) tarefas = crescerFaixas(tarefas, &capTarefas);
+                tarefas[qtdTarefas++] = f;
+                continue;
+            }
+            if (qtdPend + 2 > capPend) pend = crescerFaixas(pend, &capPend);
+            dividirFaixa(p, m->salas, f, &pend[qtdPend], &pend[qtdPend + 1]);
+            qtdPend += 2;
+        }
+        free(pend);
+    }
+    for (unsigned i = 0; i < nThreads; ++i) {
+        trab[i].tarefas = tarefas;
+        trab[i].qtdTarefas = qtdTarefas;
+        trab[i].primeira = i;
+        trab[i].salto = nThreads;
+    }
+    executarFaseEmParalelo(trab, nThreads, GER_FASE_LIGAR);
+    free(tarefas);
+    free(trab);
+
+    /* hash: suspeitos com ids 0..K-1, cada pista própria aponta para um sorteado.
+       Pista própria = escrita logo depois do nome; repetida aponta para trás. */
+    for (uint32_t k = 0; k < p->suspeitos; ++k) internarSimbolo(&ht->suspeitos, suspeitos[k]);
+    size_t pistas = 0, repetidas = 0;
+    for (uint32_t i = 0; i < m->qtd; ++i) {
+        const Sala *s = &m->salas[i];
+        if (s->pista > s->nome) pistas++;
+        else if (s->pista) repetidas++;
+    }
+    reservarHash(ht, pistas);
+    for (uint32_t i = 0; i < m->qtd; ++i) {
+        const Sala *s = &m->salas[i];
+        if (s->pista > s->nome)
+            inserirNaHashStr(ht, s->pista, suspeitos[sorteioSala(p->semente, i, 13) % p->suspeitos]);
+    }
+    free(suspeitos);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    indexarMansao(m);
+    if (rel) {
+        rel->pistas = pistas;
+        rel->repetidas = repetidas;
+        rel->bytesTexto = off;
+        rel->segundos = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    }
+    return 0;
+}
+
+/* -------------------- main: monta mapa, hash e roda exploração -------------------- */
+
+/* DQ_SEM_MAIN permite incluir este arquivo em programas auxiliares (ex.: benchmarks) */
+#ifndef DQ_SEM_MAIN
+int main(int argc, char **argv) {
+    setlocale(LC_ALL, "Portuguese");
+#ifdef DQ_ESTATISTICAS
+    atexit(despejarEstatisticas);
+#endif
+
+    if (argc == 4 && strcmp(argv[1], "--converter") == 0)
+        return converterMansaoTexto(argv[2], argv[3]) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    const char *arqMapa = NULL, *arqCaso = NULL, *arqLote = NULL, *arqSessao = NULL;
+    size_t dicaLinhas = 0;
+    ParametrosSimulacao sim = { 0, SIM_PASSOS_PADRAO, 0, 1 };
+    int simular = 0;
+    ParametrosGerador ger = { 0, FORMA_BALANCEADA, GER_DENSIDADE_PADRAO, GER_REPETIDAS_PADRAO,
+                              GER_SUSPEITOS_PADRAO, 1, 0 };
+    const char *arqGerado = NULL;
+    int formaValida = 1;
+    ModoSaida modoSaida = SAIDA_BUFFER;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--mapa") == 0 && i + 1 < argc) arqMapa = argv[++i];
+        else if (strcmp(argv[i], "--caso") == 0 && i + 1 < argc) arqCaso = argv[++i];
+        else if (strcmp(argv[i], "--linhas") == 0 && i + 1 < argc) dicaLinhas = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--lote") == 0 && i + 1 < argc) arqLote = argv[++i];
+        else if (strcmp(argv[i], "--sessao") == 0 && i + 1 < argc) arqSessao = argv[++i];
+        else if (strcmp(argv[i], "--silencioso") == 0) modoSaida = SAIDA_SILENCIOSA;
+        else if (strcmp(argv[i], "--simular") == 0 && i + 1 < argc) { sim.sessoes = strtoull(argv[++i], NULL, 10); simular = 1; }
+        else if (strcmp(argv[i], "--passos") == 0 && i + 1 < argc) sim.passos = (unsigned) strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) sim.threads = (unsigned) strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--semente") == 0 && i + 1 < argc) sim.semente = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--gerar") == 0 && i + 1 < argc) ger.salas = (uint32_t) strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--densidade") == 0 && i + 1 < argc) ger.densidade = strtod(argv[++i], NULL);
+        else if (strcmp(argv[i], "--repetidas") == 0 && i + 1 < argc) ger.repetidas = strtod(argv[++i], NULL);
+        else if (strcmp(argv[i], "--suspeitos") == 0 && i + 1 < argc) ger.suspeitos = (uint32_t) strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--gravar-mapa") == 0 && i + 1 < argc) arqGerado = argv[++i];
+        else if (strcmp(argv[i], "--forma") == 0 && i + 1 < argc) {
+            const char *f = argv[++i];
+            if (strcmp(f, "balanceada") == 0) ger.forma = FORMA_BALANCEADA;
+            else if (strcmp(f, "esquerda") == 0) ger.forma = FORMA_CADEIA_ESQUERDA;
+            else if (strcmp(f, "direita") == 0) ger.forma = FORMA_CADEIA_DIREITA;
+            else if (strcmp(f, "aleatoria") == 0) ger.forma = FORMA_ALEATORIA;
+            else formaValida = 0;
+        }
+        else formaValida = 0;
+        if (!formaValida || (arqMapa && ger.salas) || (arqGerado && !ger.salas)) {
+            fprintf(stderr, "Uso: %s [--mapa arquivo.dqm] [--caso pistas.csv [--linhas N]] [--lote sessoes.txt] [--silencioso]\n"
+                            "       %s [--mapa arquivo.dqm] [--caso pistas.csv] --sessao arquivo.dqs\n"
+                            "       %s [--mapa arquivo.dqm] --simular N [--passos P] [--threads T] [--semente S]\n"
+                            "       %s --converter entrada.txt saida.dqm\n"
+                            "       %s --gerar N [--forma balanceada|esquerda|direita|aleatoria] [--densidade D]\n"
+                            "          [--repetidas R] [--suspeitos K] [--semente S] [--threads T] [--gravar-mapa saida.dqm]\n"
+                            "          (e as opções de jogo, lote ou simulação)\n",
+                    argv[0], argv[0], argv[0], argv[0], argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Pool único de textos (salas, pistas, suspeitos), mapa e tabela hash */
+    PoolStrings strings;
+    Mansao mansao;
+    HashTable ht;
+    if (arqMapa) {
+        if (carregarMansaoBinaria(arqMapa, &mansao, &strings, &ht) != 0) return EXIT_FAILURE;
+    } else if (ger.salas) {
+        inicializarPool(&strings);
+        inicializarMansao(&mansao, &strings);
+        inicializarHash(&ht, &strings);
+        ger.semente = sim.semente;
+        ger.threads = sim.threads;
+        RelatorioGerador rel;
+        if (gerarMansao(&mansao, &ht, &ger, &rel) != 0) return EXIT_FAILURE;
+        printf("Mansão gerada: %u salas, %zu pistas distintas, %zu salas com pista repetida, "
+               "%u suspeitos, %.1f MiB de texto em %.3f s\n", mansao.qtd, rel.pistas, rel.repetidas,
+               ger.suspeitos, rel.bytesTexto / (1024.0 * 1024.0), rel.segundos);
+        if (arqGerado) {
+            int r = salvarMansaoBinaria(&mansao, &ht, arqGerado);
+            liberarHash(&ht);
+            liberarMansao(&mansao);
+            liberarPool(&strings);
+            return r == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    } else {
+        inicializarPool(&strings);
+        inicializarMansao(&mansao, &strings);
+        inicializarHash(&ht, &strings);
+        montarMansaoPadrao(&mansao, &ht);
+    }
+
+    /* Associações extras do arquivo de caso (depois do mapa: o caso prevalece);
+       no jogo, as linhas (com peso) também vão para a matriz de evidências */
+    MatrizEvidencias ev;
+    inicializarEvidencias(&ev);
+    if (arqCaso) {
+        RelatorioCarga rel;
+        if (carregarCasoCSV(&ht, arqCaso, dicaLinhas, &rel, arqLote ? NULL : &ev) != 0)
+            return EXIT_FAILURE;
+        printf("Caso %s: %zu associações (%zu linhas ignoradas) em %.3f s (%.0f linhas/s), pico de memória %ld KiB\n",
+               arqCaso, rel.linhas, rel.ignoradas, rel.segundos,
+               rel.segundos > 0 ? rel.linhas / rel.segundos : 0.0, rel.picoMemoriaKB);
+    }
+
+    /* Modo em lote: só os registros por sessão, sem menus nem acusação */
+    if (arqLote) {
+        FILE *entrada = strcmp(arqLote, "-") == 0 ? stdin : fopen(arqLote, "r");
+        if (!entrada) { perror(arqLote); return EXIT_FAILURE; }
+        int r = executarLote(&mansao, &ht, entrada, stdout);
+        if (entrada != stdin) fclose(entrada);
+        liberarHash(&ht);
+        liberarMansao(&mansao);
+        liberarPool(&strings);
+        return r == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /* Simulação: mapa, hash e evidências já completos, compartilhados só para leitura */
+    if (simular) {
+        montarEvidencias(&ev, &ht);
+        if (sim.threads == 0) {
+            long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+            sim.threads = nucleos > 0 ? (unsigned) nucleos : 1;
+        }
+        ResultadoSimulacao res;
+        int r = simularInvestigacoes(&mansao, &ht, &ev, &sim, &res);
+        if (r == 0) {
+            printf("Simulação: %zu sessões x %u passos em %u thread(s): %.3f s (%.0f sessões/s)\n",
+                   res.sessoes, sim.passos, sim.threads, res.segundos,
+                   res.segundos > 0 ? res.sessoes / res.segundos : 0.0);
+            printf("Passos: %zu; pistas distintas por sessão: %.2f\n", res.passos,
+                   res.sessoes ? (double) res.pistas / res.sessoes : 0.0);
+            printf("Acusações válidas: %zu; fracas: %zu; sem suspeito: %zu\n",
+                   res.validas, res.fracas, res.semSuspeito);
+            for (size_t k = 0; k < res.qtdSuspeitos; ++k)
+                printf(" - %s: %zu condenação(ões)\n", nomeSuspeito(&ht, (int) k), res.votos[k]);
+        } else {
+            fprintf(stderr, "Falha ao criar as threads da simulação.\n");
+        }
+        liberarResultadoSimulacao(&res);
+        liberarEvidencias(&ev);
+        liberarHash(&ht);
+        liberarMansao(&mansao);
+        liberarPool(&strings);
+        return r == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /* Investigação do jogador: BST das pistas coletadas (inicialmente vazia) e contagens */
+    Investigacao inv;
+    inicializarInvestigacao(&inv);
+    Navegacao nav;
+    iniciarNavegacao(&nav, &mansao);
+    /* sessão gravada: pistas, associações e posição substituem o estado inicial */
+    if (arqSessao && access(arqSessao, F_OK) == 0) {
+        if (carregarSessao(arqSessao, &mansao, &ht, &inv, &nav) != 0) {
+            liberarEvidencias(&ev);
+            liberarNavegacao(&nav);
+            liberarInvestigacao(&inv);
+            liberarHash(&ht);
+            liberarMansao(&mansao);
+            liberarPool(&strings);
+            return EXIT_FAILURE;
+        }
+        printf("Sessão %s retomada: %zu pista(s) coletada(s).\n", arqSessao, inv.pistasDistintas);
+        /* a hash da sessão prevalece; triplas do caso apontavam para o pool anterior.
+           O .dqs não guarda pesos: o veredito passa a usar as associações (peso 1) */
+        if (ev.qtdT > 0)
+            fprintf(stderr, "Aviso: os pesos de %s não valem na sessão retomada; "
+                            "o veredito usa as associações gravadas (peso 1).\n", arqCaso);
+        liberarEvidencias(&ev);
+    }
+    montarEvidencias(&ev, &ht);
+    Saida tela;
+    inicializarSaida(&tela, stdout, modoSaida);
+
+    saidaPrintf(&tela, "=== Detective Quest: Sistema de Investigações (versão melhorada) ===\n");
+    saidaPrintf(&tela, "Explore a mansão, colete pistas e, ao final, faça sua acusação.\n");
+    saidaPrintf(&tela, "Comandos de navegação: e (esquerda), d (direita), p (subir), vN (outra saída), b (voltar),\n"
+                       "f (avançar), h (histórico), jN (voltar direto à sala N do histórico), c (rota até a pista\n"
+                       "pendente mais próxima), q (buscar nas pistas coletadas), i (suspeitos compatíveis com\n"
+                       "todas as pistas), t (ir a uma sala pelo nome), g (gravar a sessão, com --sessao), s (sair).\n");
 
     /* Exploração interativa a partir do Hall */
-    explorarSalas(hall, &raizPistas, &ht);
+#ifdef DQ_ESTATISTICAS
+    uint64_t t0 = relogioNs();
+#endif
+    explorarSalas(&mansao, &inv, &ht, &nav, arqSessao, &tela);
+#ifdef DQ_ESTATISTICAS
+    uint64_t t1 = relogioNs();
+    estatLocal.nsExplorar += t1 - t0;
+#endif
 
     /* Fase final: acusação */
-    verificarSuspeitoFinal(raizPistas, &ht);
+    verificarSuspeitoFinal(&inv, &ht, &ev, &tela);
+#ifdef DQ_ESTATISTICAS
+    estatLocal.nsVeredito += relogioNs() - t1;
+#endif
 
-    /* Limpeza de memória */
-    liberarBST(raizPistas);
-    liberarArvore(hall);
+    /* Limpeza de memória (o pool por último: pode apontar para o arquivo mapeado) */
+    liberarEvidencias(&ev);
+    liberarNavegacao(&nav);
+    liberarInvestigacao(&inv);
     liberarHash(&ht);
+    liberarMansao(&mansao);
+    liberarPool(&strings);
 
-    printf("\nSessão encerrada. Obrigado por jogar.\n");
+    saidaPrintf(&tela, "\nSessão encerrada. Obrigado por jogar.\n");
+    liberarSaida(&tela);
     return 0;
 }
+#endif /* DQ_SEM_MAIN */
@@ -0,0 +1,1358 @@
+/*
+ Detective Quest - benchmarks dos caminhos críticos dos três níveis
+ - criarSala: árvore completa nos níveis Novato/Aventureiro (nós com malloc)
+   e no Mestre (vetor plano), mais gravação do binário e carga via mmap
+ - inserirPista / buscarPistaNode: chaves em ordem crescente (caso degenerado
+   da BST simples), aleatórias e com prefixo longo comum (comparações caras)
+ - inserirNaHash / encontrarSuspeito (presentes e ausentes) partindo de várias
+   capacidades iniciais (o papel de HASH_SIZE), com fator de carga e sondagem
+ - hashChave (16 bytes por multiplicação) contra djb2 byte a byte em frases
+   de pistas em português (UTF-8, 40 a 90 bytes), com o maior balde na máscara;
+   strcmp de textos iguais contra a comparação por StrId da BST e da hash
+ - coletarPista / contadorPistasParaSuspeito com um suspeito a cada 4 pistas
+ - coletarPistasEmLote (1 thread e 4 threads, em duas metades para intercalar
+   com o já coletado) contra coletarPista uma a uma, com 1/8 de repetidas;
+   ok se a árvore, as contagens e o ranking conferem
+ - coletarSuspeitosUnicos e verificarSuspeitoFinal completo (resumo impresso
+   em /dev/null, acusação lida de um arquivo temporário)
+ - montarEvidencias / pontuarSuspeitos: n pistas x n/10 suspeitos, 3 pesos por pista
+ - listas de suspeitos por pista (1 a 8 por pista, varint de diferenças):
+   acrescentarSuspeitoStr, bytes por associação e intersectarSuspeitos de 3
+   pistas, conferida contra a interseção ingênua
+ - percursos iterativos contra as versões recursivas de antes: inserção AVL,
+   in-order do relatório e liberarArvore (Novato) em árvore completa; em cadeia
+   degenerada de n salas só a iterativa (a recursiva estoura a pilha em 10^6)
+ - relatório de pistas e suspeitos por modo de saída (direta = um fprintf por
+   linha num destino com buffer de linha, como um terminal; buffer; silenciosa),
+   com o nº de chamadas write(2) do processo (/proc/self/io)
+ - gerarMansao (balanceada e aleatória) com as threads disponíveis, conferindo
+   que o resultado é uma árvore e igual ao gerado com uma thread
+
+ Cada medida informa ns/op, alocações/op (malloc, calloc e realloc dos
+ arquivos de nível, contados por macros) e a memória residente ao fim da
+ montagem da estrutura.
+
+ Compilar:
+    gcc -std=c11 -O2 -Wall -pthread detectiveQuestMestreBench.c -o dq_bench
+ Executar:
+    ./dq_bench [--csv] [--comparar base.csv] [expoente_max]
+       expoente_max   padrão 6 -> até 10^6 elementos; 7 -> 10^7
+       --csv          uma linha por medida: nivel,operacao,distribuicao,n,ns_op,aloc_op,rss_kb,ok,extra
+       --comparar     compara ns/op com uma execução --csv anterior; sai com 1
+                      se alguma medida ficou mais de 25% mais lenta
+    Ex.: ./dq_bench --csv 5 > base.csv; (altera o código) ./dq_bench --comparar base.csv 5
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#define DQ_SEM_MAIN
+
+/* cabeçalhos do sistema antes das macros de contagem: nenhuma declaração é reescrita */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <pthread.h>
+
+/* -------------------- Contagem de alocações dos arquivos de nível -------------------- */
+
+static size_t benchAlocacoes;
+
+static void* contarMalloc(size_t n) { benchAlocacoes++; return malloc(n); }
+static void* contarCalloc(size_t q, size_t n) { benchAlocacoes++; return calloc(q, n); }
+static void* contarRealloc(void *p, size_t n) { benchAlocacoes++; return realloc(p, n); }
+
+#define malloc(n) contarMalloc(n)
+#define calloc(q, n) contarCalloc(q, n)
+#define realloc(p, n) contarRealloc(p, n)
+
+/* Novato e Aventureiro usam os mesmos nomes que o Mestre: renomeados por nível */
+#define Sala SalaNovato
+#define criarSala criarSalaNovato
+#define explorarSalas explorarSalasNovato
+#define executarLote executarLoteNovato
+#define liberarArvore liberarArvoreNovato
+#include "detectiveQuestNovato.c"
+#undef Sala
+#undef criarSala
+#undef explorarSalas
+#undef executarLote
+#undef liberarArvore
+
+#define Sala SalaAventureiro
+#define criarSala criarSalaAventureiro
+#define explorarSalas explorarSalasAventureiro
+#define executarLote executarLoteAventureiro
+#define liberarArvore liberarArvoreAventureiro
+#include "detectiveQuestAventureiro.c"
+#undef Sala
+#undef criarSala
+#undef explorarSalas
+#undef executarLote
+#undef liberarArvore
+
+#include "detectiveQuestMestre.c"
+
+/* daqui em diante as alocações do próprio benchmark não são contadas */
+#undef malloc
+#undef calloc
+#undef realloc
+
+#define CHAVE_LEN 64     /* cabe o prefixo de 31 bytes + os 20 dígitos de um size_t + NUL */
+#define MEDIDAS_MAX 512
+#define LIMITE_REGRESSAO 1.25   /* ns/op acima de 125% da base conta como regressão */
+
+/* -------------------- Registro das medidas -------------------- */
+
+typedef enum { DIST_ORDENADA, DIST_ALEATORIA, DIST_PREFIXO } Distribuicao;
+
+static const char *nomesDist[] = { "ordenada", "aleatoria", "prefixo" };
+
+typedef struct {
+    const char *nivel;
+    char operacao[40];
+    const char *distribuicao;
+    size_t n;
+    double nsOp;
+    double alocOp;
+    long rssKB;
+    int ok;
+    char extra[48];             /* métricas próprias da estrutura (altura, carga...) */
+} Medida;
+
+static Medida medidas[MEDIDAS_MAX];
+static size_t qtdMedidas;
+static int saidaCSV;
+
+/* relógio monotônico em nanossegundos */
+static double agoraNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* memória residente atual (Linux: /proc/self/statm); pico do processo se indisponível */
+static long rssAtualKB(void) {
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        long total, residente;
+        int lidos = fscanf(f, "%ld %ld", &total, &residente);
+        fclose(f);
+        if (lidos == 2) return residente * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+    return picoMemoriaKB();
+}
+
+/* imprime a medida no formato escolhido e guarda para a comparação */
+static void registrar(const char *nivel, const char *operacao, const char *dist, size_t n,
+                      double ns, size_t alocacoes, size_t ops, long rssKB, int ok, const char *extra) {
+    if (qtdMedidas == MEDIDAS_MAX) { fprintf(stderr, "Erro: medidas demais\n"); exit(EXIT_FAILURE); }
+    Medida *m = &medidas[qtdMedidas++];
+    m->nivel = nivel;
+    snprintf(m->operacao, sizeof(m->operacao), "%s", operacao);
+    m->distribuicao = dist;
+    m->n = n;
+    m->nsOp = ns / ops;
+    m->alocOp = (double) alocacoes / ops;
+    m->rssKB = rssKB;
+    m->ok = ok;
+    snprintf(m->extra, sizeof(m->extra), "%s", extra ? extra : "");
+
+    if (saidaCSV)
+        printf("%s,%s,%s,%zu,%.1f,%.4f,%ld,%d,%s\n", m->nivel, m->operacao, m->distribuicao,
+               m->n, m->nsOp, m->alocOp, m->rssKB, m->ok, m->extra);
+    else
+        printf("%-12s %-26s %-10s %10zu %12.1f %10.4f %10ld %-5s %s\n", m->nivel, m->operacao,
+               m->distribuicao, m->n, m->nsOp, m->alocOp, m->rssKB, m->ok ? "ok" : "FALHA", m->extra);
+    fflush(stdout);
+}
+
+/* -------------------- Geração de chaves -------------------- */
+
+/* xorshift64: gerador determinístico para embaralhar as chaves */
+static unsigned long long proxAleatorio(unsigned long long *estado) {
+    unsigned long long x = *estado;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *estado = x;
+}
+
+/* embaralhar: Fisher-Yates sobre vetor de chaves */
+static void embaralhar(char (*chaves)[CHAVE_LEN], size_t n, unsigned long long estado) {
+    char tmp[CHAVE_LEN];
+    for (size_t i = n - 1; i > 0; --i) {
+        size_t j = (size_t)(proxAleatorio(&estado) % (i + 1));
+        memcpy(tmp, chaves[i], CHAVE_LEN);
+        memcpy(chaves[i], chaves[j], CHAVE_LEN);
+        memcpy(chaves[j], tmp, CHAVE_LEN);
+    }
+}
+
+/* gera n chaves distintas na distribuição pedida:
+   ordenada "pista 000000001"..; aleatoria = as mesmas embaralhadas;
+   prefixo = 30 caracteres comuns antes do número, embaralhadas */
+static char (*gerarChaves(size_t n, Distribuicao d))[CHAVE_LEN] {
+    char (*chaves)[CHAVE_LEN] = malloc(n * sizeof *chaves);
+    if (!chaves) { fprintf(stderr, "Erro: memória para chaves\n"); exit(EXIT_FAILURE); }
+    const char *formato = d == DIST_PREFIXO ? "pegada de lama perto da janela %09zu" : "pista %09zu";
+    for (size_t i = 0; i < n; ++i)
+        snprintf(chaves[i], CHAVE_LEN, formato, i);
+    if (d != DIST_ORDENADA) embaralhar(chaves, n, 0x9E3779B97F4A7C15ULL);
+    return chaves;
+}
+
+/* -------------------- criarSala (três níveis) -------------------- */
+
+/* árvore completa de n salas com nós alocados um a um (Novato/Aventureiro) */
+#define BENCH_ARVORE_NIVEL(funcao, TipoSala, criar, liberar)                          \
+static void funcao(size_t n, const char *nivel) {                                     \
+    TipoSala **nos = malloc(n * sizeof *nos);                                         \
+    if (!nos) { fprintf(stderr, "Erro: memória para nós\n"); exit(EXIT_FAILURE); }    \
+    char nome[CHAVE_LEN];                                                             \
+    size_t aloc0 = benchAlocacoes;                                                    \
+    double t0 = agoraNs();                                                            \
+    for (size_t i = 0; i < n; ++i) {                                                  \
+        snprintf(nome, sizeof(nome), "Sala %zu", i);                                  \
+        nos[i] = criar(nome);                                                         \
+        if (i > 0) {                                                                  \
+            TipoSala *pai = nos[(i - 1) / 2];                                         \
+            if (i & 1) pai->esquerda = nos[i]; else pai->direita = nos[i];            \
+        }                                                                             \
+    }                                                                                 \
+    double t1 = agoraNs();                                                            \
+    size_t aloc = benchAlocacoes - aloc0;                                             \
+    long rss = rssAtualKB();                                                          \
+    int ok = strcmp(nos[n - 1]->nome, nome) == 0;                                     \
+    liberar(nos[0]);                                                                  \
+    free(nos);                                                                        \
+    registrar(nivel, "criarSala", "completa", n, t1 - t0, aloc, n, rss, ok, "");      \
+}
+
+BENCH_ARVORE_NIVEL(benchCriarSalaNovato, SalaNovato, criarSalaNovato, liberarArvoreNovato)
+BENCH_ARVORE_NIVEL(benchCriarSalaAventureiro, SalaAventureiro, criarSalaAventureiro, liberarArvoreAventureiro)
+
+/* gerarMansao: n salas; ok se cada sala (fora o Hall) tem exatamente um pai e
+   se o mapa com todas as threads é o mesmo de uma thread só */
+static void benchGerador(size_t n, FormaMansao forma, const char *dist) {
+    Sala *referencia = NULL;
+    for (int rodada = 0; rodada < 2; ++rodada) {
+        PoolStrings ps;
+        inicializarPool(&ps);
+        Mansao m;
+        inicializarMansao(&m, &ps);
+        HashTable ht;
+        inicializarHash(&ht, &ps);
+        ParametrosGerador p = { (uint32_t) n, forma, GER_DENSIDADE_PADRAO, GER_REPETIDAS_PADRAO,
+                                GER_SUSPEITOS_PADRAO, 42, rodada == 0 ? 1 : 0 };
+        RelatorioGerador rel;
+        size_t aloc0 = benchAlocacoes;
+        double t0 = agoraNs();
+        int ok = gerarMansao(&m, &ht, &p, &rel) == 0;
+        double t1 = agoraNs();
+        size_t filhos = 0;
+        for (uint32_t i = 0; ok && i < m.qtd; ++i) {
+            filhos += (m.salas[i].esquerda != SALA_NENHUMA) + (m.salas[i].direita != SALA_NENHUMA);
+            if (i > 0 && salaPai(&m, i) >= i) ok = 0; /* pré-ordem: o pai vem antes */
+        }
+        ok = ok && filhos == n - 1 && ht.qtd == rel.pistas;
+        if (rodada == 0) {
+            referencia = malloc(n * sizeof(Sala));
+            if (!referencia) { fprintf(stderr, "Erro: memória para salas\n"); exit(EXIT_FAILURE); }
+            memcpy(referencia, m.salas, n * sizeof(Sala));
+        } else {
+            ok = ok && memcmp(referencia, m.salas, n * sizeof(Sala)) == 0;
+            char extra[48];
+            snprintf(extra, sizeof(extra), "threads=%ld pistas=%zu", sysconf(_SC_NPROCESSORS_ONLN), rel.pistas);
+            registrar("mestre", "gerarMansao", dist, n, t1 - t0, benchAlocacoes - aloc0, n, rssAtualKB(), ok, extra);
+        }
+        liberarHash(&ht);
+        liberarMansao(&m);
+        liberarPool(&ps);
+    }
+    free(referencia);
+}
+
+/* montagem com criarSala (vetor plano), gravação do binário e carga por mmap
+   do mesmo mapa (o tempo de partida de um jogo com --mapa) */
+static void benchMansao(size_t n) {
+    PoolStrings ps;
+    inicializarPool(&ps);
+    Mansao m;
+    inicializarMansao(&m, &ps);
+    HashTable ht;
+    inicializarHash(&ht, &ps);
+    char nome[CHAVE_LEN];
+
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    for (size_t i = 0; i < n; ++i) {
+        snprintf(nome, CHAVE_LEN, "Sala %zu", i);
+        uint32_t s = criarSala(&m, nome, (i % 3) ? "" : nome);
+        if (i > 0) {
+            Sala *pai = &m.salas[(i - 1) / 2];
+            if (i & 1) pai->esquerda = s; else pai->direita = s;
+        }
+        if (i % 3 == 0) inserirNaHashStr(&ht, m.salas[s].pista, m.salas[s].nome);
+    }
+    double t1 = agoraNs();
+    size_t aloc1 = benchAlocacoes;
+    long rss = rssAtualKB();
+    registrar("mestre", "criarSala", "completa", n, t1 - t0, aloc1 - aloc0, n, rss, m.qtd == n, "");
+
+    const char *caminho = "/tmp/dq_bench_mansao.dqm";
+    if (salvarMansaoBinaria(&m, &ht, caminho) != 0) exit(EXIT_FAILURE);
+    double t2 = agoraNs();
+    registrar("mestre", "salvarMansaoBinaria", "completa", n, t2 - t1, benchAlocacoes - aloc1, n, rss, 1, "");
+    liberarHash(&ht);
+    liberarMansao(&m);
+    liberarPool(&ps);
+
+    PoolStrings psMapa;
+    Mansao mMapa;
+    HashTable htMapa;
+    size_t aloc2 = benchAlocacoes;
+    double t3 = agoraNs();
+    if (carregarMansaoBinaria(caminho, &mMapa, &psMapa, &htMapa) != 0) exit(EXIT_FAILURE);
+    double t4 = agoraNs();
+    /* percorre o caminho mais à esquerda direto na região mapeada */
+    uint32_t atual = 0, passos = 0;
+    while (mMapa.salas[atual].esquerda != SALA_NENHUMA) { atual = mMapa.salas[atual].esquerda; passos++; }
+    /* pais e ordem dos nomes vêm do arquivo, sem montagem na carga */
+    int ok = mMapa.qtd == n && encontrarSuspeitoIdStr(&htMapa, mMapa.salas[0].pista) >= 0 &&
+             mMapa.indiceMapeado && (n < 2 || salaPai(&mMapa, (uint32_t) n - 1) == (uint32_t) (n - 2) / 2);
+    char extra[48];
+    snprintf(extra, sizeof(extra), "profundidade=%u indice=mapeado", passos);
+    registrar("mestre", "carregarMansaoBinaria", "completa", n, t4 - t3, benchAlocacoes - aloc2, n,
+              rssAtualKB(), ok, extra);
+
+    /* busca por nome: binária na ordem de nomes gravada no arquivo, sem índice em memória */
+    size_t aloc3 = benchAlocacoes, achadas = 0;
+    double t5 = agoraNs();
+    for (size_t i = 0; i < n; ++i) {
+        size_t k = (i * 2654435761u) % n;
+        snprintf(nome, CHAVE_LEN, "Sala %zu", k);
+        achadas += buscarSalaPorNome(&mMapa, nome) == k;
+    }
+    double t6 = agoraNs();
+    registrar("mestre", "buscarSalaPorNome", "aleatoria", n, t6 - t5, benchAlocacoes - aloc3, n,
+              rssAtualKB(), achadas == n, "");
+
+    liberarHash(&htMapa);
+    liberarMansao(&mMapa);
+    liberarPool(&psMapa);
+    remove(caminho);
+}
+
+/* -------------------- busca por prefixo / trecho nas pistas -------------------- */
+
+/* varreduras lineares de referência: o que se fazia antes, percorrendo todas as pistas */
+static size_t varrerPrefixo(const PoolStrings *ps, const StrId *ids, size_t n, const char *prefixo) {
+    size_t tam = strlen(prefixo), qtd = 0;
+    for (size_t i = 0; i < n; ++i) qtd += strncmp(texto(ps, ids[i]), prefixo, tam) == 0;
+    return qtd;
+}
+
+static size_t varrerTrecho(const PoolStrings *ps, const StrId *ids, size_t n, const char *trecho) {
+    size_t qtd = 0;
+    for (size_t i = 0; i < n; ++i) qtd += strstr(texto(ps, ids[i]), trecho) != NULL;
+    return qtd;
+}
+
+/* pistas "<objeto> <detalhe> <local> <número>": consultas raras e frequentes */
+static void benchBuscaTexto(size_t n) {
+    static const char *objetos[] = { "pegada", "luva", "bilhete", "xícara", "fio", "anel", "faca", "chave" };
+    static const char *detalhes[] = { "de lama", "rasgada", "com sangue", "molhada", "queimada", "azul" };
+    static const char *locais[] = { "no jardim", "na cozinha", "no porão", "na biblioteca", "no hall" };
+    PoolStrings ps;
+    inicializarPool(&ps);
+    StrId *ids = malloc(n * sizeof *ids);
+    StrId *res = malloc(n * sizeof *res);
+    if (!ids || !res) { fprintf(stderr, "Erro: memória para pistas\n"); exit(EXIT_FAILURE); }
+    char buf[CHAVE_LEN * 2];
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t h = misturar64(i);
+        snprintf(buf, sizeof buf, "%s %s %s %zu", objetos[h % 8], detalhes[(h >> 8) % 6], locais[(h >> 16) % 5], i);
+        ids[i] = internarString(&ps, buf);
+    }
+    Arena arena;
+    inicializarArena(&arena);
+    BSTNode *raiz = NULL;
+    for (size_t i = 0; i < n; ++i) raiz = inserirPista(&arena, &ps, raiz, ids[i], -1, NULL);
+
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    IndiceTrigramas ix;
+    indexarTrigramas(&ix, &ps, ids, n);
+    double t1 = agoraNs();
+    char extra[48];
+    snprintf(extra, sizeof(extra), "trigramas=%zu", ix.qtdTrigramas);
+    registrar("mestre", "indexarTrigramas", "pistas", n, t1 - t0, benchAlocacoes - aloc0, n, rssAtualKB(), 1, extra);
+
+    /* prefixo raro (um número), prefixo comum e trechos raro/comum */
+    char raro[32];
+    snprintf(raro, sizeof raro, " %zu", n / 3);
+    const char *prefixos[] = { "luva rasgada na cozinha", "pegada" };
+    const char *trechos[] = { raro, "queimada no porão" };
+    const int repeticoes = 20;
+    for (int k = 0; k < 2; ++k) {
+        size_t qIdx = 0, qLin = 0;
+        double a = agoraNs();
+        for (int r = 0; r < repeticoes; ++r) qIdx = buscarPistasPorPrefixo(&ps, raiz, prefixos[k], res, n);
+        double b = agoraNs();
+        for (int r = 0; r < repeticoes; ++r) qLin = varrerPrefixo(&ps, ids, n, prefixos[k]);
+        double c = agoraNs();
+        snprintf(extra, sizeof(extra), "resultados=%zu", qIdx);
+        registrar("mestre", "buscarPistasPorPrefixo", k ? "comum" : "raro", n, b - a, 0, repeticoes, rssAtualKB(), qIdx == qLin, extra);
+        registrar("mestre", "prefixo(varredura)", k ? "comum" : "raro", n, c - b, 0, repeticoes, rssAtualKB(), 1, extra);
+
+        a = agoraNs();
+        for (int r = 0; r < repeticoes; ++r) qIdx = buscarPorTrecho(&ix, &ps, trechos[k], res, n);
+        b = agoraNs();
+        for (int r = 0; r < repeticoes; ++r) qLin = varrerTrecho(&ps, ids, n, trechos[k]);
+        c = agoraNs();
+        snprintf(extra, sizeof(extra), "resultados=%zu", qIdx);
+        registrar("mestre", "buscarPorTrecho", k ? "comum" : "raro", n, b - a, 0, repeticoes, rssAtualKB(), qIdx == qLin, extra);
+        registrar("mestre", "trecho(varredura)", k ? "comum" : "raro", n, c - b, 0, repeticoes, rssAtualKB(), 1, extra);
+    }
+
+    liberarTrigramas(&ix);
+    liberarArena(&arena);
+    liberarPool(&ps);
+    free(ids);
+    free(res);
+}
+
+/* -------------------- grafo da mansão e planejador de rotas -------------------- */
+
+/* árvore completa + n/4 passagens aleatórias; pistas em ~1 a cada 4096 salas,
+   então cada busca percorre boa parte do grafo antes de achar uma pendente */
+static void benchRotas(size_t n) {
+    PoolStrings ps;
+    inicializarPool(&ps);
+    Mansao m;
+    inicializarMansao(&m, &ps);
+    char nome[CHAVE_LEN];
+    for (size_t i = 0; i < n; ++i) {
+        snprintf(nome, CHAVE_LEN, "Sala %zu", i);
+        int comPista = misturar64(i) % 4096 == 0 || i == n - 1;
+        uint32_t s = criarSala(&m, nome, comPista ? nome : "");
+        if (i > 0) {
+            Sala *pai = &m.salas[(i - 1) / 2];
+            if (i & 1) pai->esquerda = s; else pai->direita = s;
+        }
+    }
+    for (size_t k = 0; k < n / 4; ++k)
+        conectarPassagem(&m, (uint32_t) (misturar64(2 * k + 1) % n), (uint32_t) (misturar64(2 * k + 2) % n));
+
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    indexarMansao(&m);
+    double t1 = agoraNs();
+    char extra[48];
+    snprintf(extra, sizeof(extra), "arestas=%u", m.inicioVizinhos[m.qtd]);
+    registrar("mestre", "indexarMansao", "grafo", n, t1 - t0, benchAlocacoes - aloc0, n, rssAtualKB(),
+              m.inicioVizinhos[m.qtd] <= 2 * (n - 1) + 2 * (n / 4), extra); /* passagens em laço são omitidas */
+
+    Investigacao inv;
+    inicializarInvestigacao(&inv);
+    PlanejadorRota pr;
+    iniciarPlanejador(&pr, &m);
+    const size_t consultas = 1000;
+    size_t achadas = 0, somaPassos = 0;
+    aloc0 = benchAlocacoes;
+    double t2 = agoraNs();
+    for (size_t q = 0; q < consultas; ++q) {
+        size_t passos;
+        uint32_t origem = (uint32_t) (misturar64(q ^ 0x5EED) % n);
+        if (planejarRotaPista(&pr, &m, &inv, origem, &passos) != SALA_NENHUMA) {
+            achadas++;
+            somaPassos += passos;
+        }
+    }
+    double t3 = agoraNs();
+    snprintf(extra, sizeof(extra), "passos_medios=%.1f", achadas ? (double) somaPassos / achadas : 0.0);
+    registrar("mestre", "planejarRotaPista", "aleatoria", n, t3 - t2, benchAlocacoes - aloc0, consultas,
+              rssAtualKB(), achadas == consultas, extra);
+
+    liberarPlanejador(&pr);
+    liberarInvestigacao(&inv);
+    liberarMansao(&m);
+    liberarPool(&ps);
+}
+
+/* -------------------- inserirPista / buscarPistaNode -------------------- */
+
+/* inserção na ordem da distribuição; busca sempre em ordem aleatória */
+static void benchIndicePistas(size_t n, Distribuicao d) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, d);
+    char (*consultas)[CHAVE_LEN] = malloc(n * sizeof *consultas);
+    if (!consultas) { fprintf(stderr, "Erro: memória para consultas\n"); exit(EXIT_FAILURE); }
+    memcpy(consultas, chaves, n * sizeof *chaves);
+    embaralhar(consultas, n, 0xD1B54A32D192ED03ULL);
+
+    /* textos internados antes da medição: a BST recebe StrId, como na coleta */
+    PoolStrings ps;
+    inicializarPool(&ps);
+    StrId *ids = malloc(n * sizeof *ids);
+    if (!ids) { fprintf(stderr, "Erro: memória para ids\n"); exit(EXIT_FAILURE); }
+    for (size_t i = 0; i < n; ++i) ids[i] = internarString(&ps, chaves[i]);
+
+    Arena arena;
+    inicializarArena(&arena);
+    BSTNode *raiz = NULL;
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    for (size_t i = 0; i < n; ++i) raiz = inserirPista(&arena, &ps, raiz, ids[i], -1, NULL);
+    double t1 = agoraNs();
+    size_t aloc1 = benchAlocacoes;
+    long rss = rssAtualKB();
+    size_t achadas = 0;
+    for (size_t i = 0; i < n; ++i) achadas += buscarPistaNode(&ps, raiz, consultas[i]) != NULL;
+    double t2 = agoraNs();
+
+    char extra[48];
+    snprintf(extra, sizeof(extra), "altura=%d", alturaNo(raiz));
+    registrar("mestre", "inserirPista", nomesDist[d], n, t1 - t0, aloc1 - aloc0, n, rss, 1, extra);
+    registrar("mestre", "buscarPistaNode", nomesDist[d], n, t2 - t1, benchAlocacoes - aloc1, n, rss,
+              achadas == n, extra);
+
+    liberarArena(&arena);
+    liberarPool(&ps);
+    free(ids);
+    free(consultas);
+    free(chaves);
+}
+
+/* -------------------- inserirNaHash / encontrarSuspeito -------------------- */
+
+/* parte da capacidade inicial dada (HASH_SIZE no jogo) e cresce com a carga */
+static void benchHash(size_t n, size_t capacidade, Distribuicao d) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, d);
+    PoolStrings ps;
+    inicializarPool(&ps);
+    HashTable ht;
+    inicializarHashCapacidade(&ht, &ps, capacidade);
+
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    for (size_t i = 0; i < n; ++i) inserirNaHash(&ht, chaves[i], (i & 1) ? "Sr. Morais" : "Condessa");
+    double t1 = agoraNs();
+    size_t aloc1 = benchAlocacoes;
+    long rss = rssAtualKB();
+    size_t achadas = 0;
+    for (size_t i = 0; i < n; ++i) achadas += encontrarSuspeito(&ht, chaves[i]) != NULL;
+    double t2 = agoraNs();
+    char ausente[CHAVE_LEN];
+    size_t falsas = 0;
+    for (size_t i = 0; i < n; ++i) {
+        snprintf(ausente, CHAVE_LEN, "ausente %zu", i);
+        falsas += encontrarSuspeito(&ht, ausente) != NULL;
+    }
+    double t3 = agoraNs();
+
+    EstatisticasHash est;
+    estatisticasHash(&ht, &est);
+    char operacao[32], extra[48];
+    snprintf(extra, sizeof(extra), "carga=%.2f sond=%.2f/%u", est.fatorCarga, est.sondagemMedia, est.sondagemMax);
+    snprintf(operacao, sizeof(operacao), "inserirNaHash@%zu", capacidade);
+    registrar("mestre", operacao, nomesDist[d], n, t1 - t0, aloc1 - aloc0, n, rss, 1, extra);
+    snprintf(operacao, sizeof(operacao), "encontrarSuspeito@%zu", capacidade);
+    registrar("mestre", operacao, nomesDist[d], n, t2 - t1, 0, n, rss, achadas == n, extra);
+    snprintf(operacao, sizeof(operacao), "encontrarAusente@%zu", capacidade);
+    registrar("mestre", operacao, nomesDist[d], n, t3 - t2, 0, n, rss, falsas == 0, extra);
+
+    liberarHash(&ht);
+    liberarPool(&ps);
+    free(chaves);
+}
+
+/* hashChave da versão anterior: djb2 e finalização do murmur3 */
+static unsigned int hashChaveDjb2(const char *chave) {
+    unsigned int h = (unsigned int) hash_djb2(chave);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/* maiorBalde: n hashes em n baldes (máscara, como na hash) -> maior ocupação */
+static unsigned maiorBalde(const unsigned *hashes, size_t n) {
+    size_t cap = 1;
+    while (cap < n) cap <<= 1;
+    unsigned *baldes = calloc(cap, sizeof *baldes), maior = 0;
+    if (!baldes) { fprintf(stderr, "Erro: memória para baldes\n"); exit(EXIT_FAILURE); }
+    for (size_t i = 0; i < n; ++i) {
+        unsigned c = ++baldes[hashes[i] & (cap - 1)];
+        if (c > maior) maior = c;
+    }
+    free(baldes);
+    return maior;
+}
+
+/* frases de pistas em português: "xícara quebrada perto da lareira do salão nº 123" */
+static char* gerarFrases(size_t n, size_t *inicioFrases) {
+    static const char *objetos[] = { "xícara quebrada", "pegada de barro", "fio de cabelo loiro",
+        "página arrancada do diário", "anel com inicial gravada", "mancha de tinta azul",
+        "bilhete com ameaça", "faca limpa no balcão", "botão de punho", "lenço bordado" };
+    static const char *lugares[] = { "perto da lareira", "sob o tapete", "atrás da cortina",
+        "no peitoril da janela", "junto à escadaria", "embaixo da poltrona", "na gaveta" };
+    static const char *comodos[] = { "do salão", "da cozinha", "do escritório", "da biblioteca",
+        "do porão", "do jardim de inverno", "da sala de música", "do quarto de hóspedes" };
+    char *texto = malloc(n * 128);
+    if (!texto) { fprintf(stderr, "Erro: memória para frases\n"); exit(EXIT_FAILURE); }
+    size_t usado = 0;
+    uint64_t estado = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < n; ++i) {
+        inicioFrases[i] = usado;
+        uint64_t a = proximoAleatorio(&estado);
+        int tam = snprintf(texto + usado, 128, "%s %s %s nº %zu", objetos[a % 10], lugares[(a >> 8) % 7],
+                           comodos[(a >> 16) % 8], i);
+        usado += (size_t) tam + 1;
+    }
+    return texto;
+}
+
+static void benchHashTexto(size_t n) {
+    size_t *inicio = malloc(n * sizeof *inicio);
+    unsigned *hashes = malloc(n * sizeof *hashes);
+    if (!inicio || !hashes) { fprintf(stderr, "Erro: memória para hashes\n"); exit(EXIT_FAILURE); }
+    char *frases = gerarFrases(n, inicio);
+    size_t bytes = 0;
+    for (size_t i = 0; i < n; ++i) bytes += strlen(frases + inicio[i]);
+
+    double t0 = agoraNs();
+    for (size_t i = 0; i < n; ++i) hashes[i] = hashChaveDjb2(frases + inicio[i]);
+    double t1 = agoraNs();
+    unsigned maiorDjb2 = maiorBalde(hashes, n);
+    double t2 = agoraNs();
+    for (size_t i = 0; i < n; ++i) hashes[i] = hashChave(frases + inicio[i]);
+    double t3 = agoraNs();
+    unsigned maior = maiorBalde(hashes, n);
+    char extra[48];
+    snprintf(extra, sizeof(extra), "%.1f B/ns balde=%u", (double) bytes / (t1 - t0), maiorDjb2);
+    registrar("mestre", "hashDjb2", "frases", n, t1 - t0, 0, n, rssAtualKB(), 1, extra);
+    snprintf(extra, sizeof(extra), "%.1f B/ns balde=%u", (double) bytes / (t3 - t2), maior);
+    registrar("mestre", "hashChave", "frases", n, t3 - t2, 0, n, rssAtualKB(), maior <= 2 * maiorDjb2 + 4, extra);
+
+    /* igualdade: strcmp de cópias com o mesmo texto contra StrId do pool */
+    char *copia = malloc(inicio[n - 1] + strlen(frases + inicio[n - 1]) + 1);
+    if (!copia) { fprintf(stderr, "Erro: memória para frases\n"); exit(EXIT_FAILURE); }
+    memcpy(copia, frases, inicio[n - 1] + strlen(frases + inicio[n - 1]) + 1);
+    PoolStrings ps;
+    inicializarPool(&ps);
+    StrId *ids = malloc(n * sizeof *ids);
+    if (!ids) { fprintf(stderr, "Erro: memória para ids\n"); exit(EXIT_FAILURE); }
+    for (size_t i = 0; i < n; ++i) ids[i] = internarString(&ps, frases + inicio[i]);
+    size_t iguais = 0;
+    double t4 = agoraNs();
+    for (size_t i = 0; i < n; ++i) iguais += strcmp(frases + inicio[i], copia + inicio[i]) == 0;
+    double t5 = agoraNs();
+    size_t iguaisId = 0;
+    for (size_t i = 0; i < n; ++i) iguaisId += ids[i] == buscarString(&ps, copia + inicio[i]);
+    double t6 = agoraNs();
+    registrar("mestre", "strcmp", "frases", n, t5 - t4, 0, n, rssAtualKB(), iguais == n, "textos iguais");
+    registrar("mestre", "buscarString", "frases", n, t6 - t5, 0, n, rssAtualKB(), iguaisId == n,
+              "texto -> StrId (hash + 1 strcmp)");
+
+    liberarPool(&ps);
+    free(ids);
+    free(copia);
+    free(frases);
+    free(hashes);
+    free(inicio);
+}
+
+/* -------------------- Suspeitos: agregação, contagem e veredito -------------------- */
+
+/* hash com n pistas e um suspeito a cada 4 pistas */
+static void montarCaso(size_t n, PoolStrings *ps, HashTable *ht, char (*chaves)[CHAVE_LEN]) {
+    inicializarPool(ps);
+    inicializarHash(ht, ps);
+    char nome[CHAVE_LEN];
+    for (size_t i = 0; i < n; ++i) {
+        snprintf(nome, CHAVE_LEN, "Suspeito %zu", i / 4);
+        inserirNaHash(ht, chaves[i], nome);
+    }
+}
+
+/* coletarSuspeitosUnicos: linear no nº de slots + suspeitos */
+static void benchSuspeitosUnicos(size_t n) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, DIST_ALEATORIA);
+    PoolStrings ps;
+    HashTable ht;
+    montarCaso(n, &ps, &ht, chaves);
+
+    ResumoSuspeitos r;
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    coletarSuspeitosUnicos(&ht, &r);
+    double t1 = agoraNs();
+    char extra[48];
+    snprintf(extra, sizeof(extra), "suspeitos=%zu", r.qtd);
+    registrar("mestre", "coletarSuspeitosUnicos", "aleatoria", n, t1 - t0, benchAlocacoes - aloc0, n,
+              rssAtualKB(), r.qtd == (n + 3) / 4, extra);
+
+    liberarResumoSuspeitos(&r);
+    liberarHash(&ht);
+    liberarPool(&ps);
+    free(chaves);
+}
+
+/* coletarPista de todas as pistas e contadorPistasParaSuspeito de cada suspeito */
+static void benchContagemSuspeitos(size_t n) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, DIST_ALEATORIA);
+    PoolStrings ps;
+    HashTable ht;
+    montarCaso(n, &ps, &ht, chaves);
+    size_t qtdSuspeitos = (n + 3) / 4;
+    char (*nomes)[CHAVE_LEN] = malloc(qtdSuspeitos * sizeof *nomes);
+    if (!nomes) { fprintf(stderr, "Erro: memória para nomes\n"); exit(EXIT_FAILURE); }
+    for (size_t i = 0; i < qtdSuspeitos; ++i) snprintf(nomes[i], CHAVE_LEN, "Suspeito %zu", i);
+    embaralhar(nomes, qtdSuspeitos, 0xA0761D6478BD642FULL);
+    StrId *ids = malloc(n * sizeof *ids);
+    if (!ids) { fprintf(stderr, "Erro: memória para ids\n"); exit(EXIT_FAILURE); }
+    for (size_t i = 0; i < n; ++i) ids[i] = buscarString(&ps, chaves[i]);
+
+    Investigacao inv;
+    inicializarInvestigacao(&inv);
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    for (size_t i = 0; i < n; ++i) coletarPista(&inv, &ht, ids[i]);
+    double t1 = agoraNs();
+    size_t aloc1 = benchAlocacoes;
+    long rss = rssAtualKB();
+    long total = 0;
+    for (size_t i = 0; i < qtdSuspeitos; ++i) total += contadorPistasParaSuspeito(&inv, &ht, nomes[i]);
+    double t2 = agoraNs();
+
+    /* ranking incremental: ordem não crescente e topo igual ao máximo das contagens */
+    int ordenado = inv.qtdRanking > 0;
+    for (size_t k = 1; k < inv.qtdRanking; ++k)
+        ordenado &= inv.pistasPorSuspeito[inv.ranking[k - 1]] >= inv.pistasPorSuspeito[inv.ranking[k]];
+    for (size_t id = 0; id < inv.capSuspeitos; ++id)
+        ordenado &= inv.pistasPorSuspeito[id] <= inv.pistasPorSuspeito[inv.maisCitado];
+    registrar("mestre", "coletarPista", "aleatoria", n, t1 - t0, aloc1 - aloc0, n, rss,
+              inv.pistasDistintas == n && ordenado, "com ranking");
+    registrar("mestre", "contadorPistasParaSuspeito", "aleatoria", n, t2 - t1, benchAlocacoes - aloc1,
+              qtdSuspeitos, rss, total == (long) n, "");
+
+    liberarInvestigacao(&inv);
+    liberarHash(&ht);
+    liberarPool(&ps);
+    free(ids);
+    free(nomes);
+    free(chaves);
+}
+
+/* verificarSuspeitoFinal completo: resumo das n pistas e lista de suspeitos vão
+   para /dev/null; a acusação de cada repetição vem de um arquivo temporário */
+static void benchVeredito(size_t n) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, DIST_ALEATORIA);
+    PoolStrings ps;
+    HashTable ht;
+    montarCaso(n, &ps, &ht, chaves);
+    Investigacao inv;
+    inicializarInvestigacao(&inv);
+    for (size_t i = 0; i < n; ++i) coletarPista(&inv, &ht, buscarString(&ps, chaves[i]));
+
+    size_t reps = n <= 10000 ? 100 : 3;
+    char modelo[] = "/tmp/dq_bench_entradaXXXXXX";
+    int fdEntrada = mkstemp(modelo);
+    if (fdEntrada < 0) { perror("mkstemp"); exit(EXIT_FAILURE); }
+    remove(modelo);
+    FILE *f = fdopen(fdEntrada, "w+");
+    for (size_t r = 0; r < reps; ++r) fputs("\nSuspeito 0\n", f); /* fim da linha anterior + acusado */
+    fflush(f);
+    rewind(f);
+
+    fflush(stdout);
+    int salvaEntrada = dup(STDIN_FILENO), salvaSaida = dup(STDOUT_FILENO);
+    int nulo = open("/dev/null", O_WRONLY);
+    dup2(fileno(f), STDIN_FILENO);
+    dup2(nulo, STDOUT_FILENO);
+
+    Saida out;
+    inicializarSaida(&out, stdout, SAIDA_BUFFER);
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    MatrizEvidencias ev;
+    inicializarEvidencias(&ev);
+    montarEvidencias(&ev, &ht);
+    for (size_t r = 0; r < reps; ++r) verificarSuspeitoFinal(&inv, &ht, &ev, &out);
+    fflush(stdout);
+    double t1 = agoraNs();
+    size_t aloc = benchAlocacoes - aloc0;
+    liberarSaida(&out);
+
+    dup2(salvaSaida, STDOUT_FILENO);
+    dup2(salvaEntrada, STDIN_FILENO);
+    close(salvaSaida);
+    close(salvaEntrada);
+    close(nulo);
+    fclose(f);
+    clearerr(stdin);
+
+    /* uma execução = resumo de n pistas: ns/op é por pista impressa */
+    char extra[48];
+    snprintf(extra, sizeof(extra), "ms/veredito=%.3f", (t1 - t0) / reps / 1e6);
+    registrar("mestre", "verificarSuspeitoFinal", "aleatoria", n, t1 - t0, aloc, reps * n, rssAtualKB(),
+              contadorPistasParaSuspeito(&inv, &ht, "Suspeito 0") == 4, extra);
+
+    liberarEvidencias(&ev);
+    liberarInvestigacao(&inv);
+    liberarHash(&ht);
+    liberarPool(&ps);
+    free(chaves);
+}
+
+/* evidências ponderadas: n pistas, n/10 suspeitos, 3 suspeitos (pesos
+   sorteados) por pista, todas coletadas; montagem do CSR e uma pontuação.
+   ok se a soma dos pontos bate com a soma dos pesos e o ranking é decrescente */
+static void benchEvidencias(size_t n) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, DIST_ALEATORIA);
+    PoolStrings ps;
+    HashTable ht;
+    montarCaso(n, &ps, &ht, chaves);
+    size_t qtdSuspeitos = n / 10 ? n / 10 : 1;
+    StrId *suspeitos = malloc(qtdSuspeitos * sizeof *suspeitos);
+    if (!suspeitos) { fprintf(stderr, "Erro: memória para suspeitos\n"); exit(EXIT_FAILURE); }
+    char nome[CHAVE_LEN];
+    for (size_t k = 0; k < qtdSuspeitos; ++k) {
+        snprintf(nome, CHAVE_LEN, "Suspeito %zu", k);
+        suspeitos[k] = internarString(&ps, nome);
+    }
+    MatrizEvidencias ev;
+    inicializarEvidencias(&ev);
+    Investigacao inv;
+    inicializarInvestigacao(&inv);
+    double somaPesos = 0.0;
+    uint64_t estado = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < n; ++i) {
+        StrId p = buscarString(&ps, chaves[i]);
+        for (int k = 0; k < 3; ++k) {
+            float peso = (float) (proximoAleatorio(&estado) % 100 + 1) / 10.0f;
+            adicionarEvidencia(&ev, &ht, p, suspeitos[proximoAleatorio(&estado) % qtdSuspeitos], peso);
+            somaPesos += peso;
+        }
+        coletarPista(&inv, &ht, p);
+    }
+
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    montarEvidencias(&ev, &ht);
+    double t1 = agoraNs();
+    size_t aloc1 = benchAlocacoes;
+    PontuacaoSuspeitos pt;
+    memset(&pt, 0, sizeof pt);
+    size_t pontuados = pontuarSuspeitos(&ev, &inv, &pt);
+    double t2 = agoraNs();
+
+    double dif = pt.total - somaPesos;
+    int ok = (dif < 0 ? -dif : dif) <= 1e-6 * somaPesos;
+    for (size_t k = 1; k < pontuados; ++k) ok &= pt.pontos[pt.ranking[k - 1]] >= pt.pontos[pt.ranking[k]];
+    char extra[48];
+    snprintf(extra, sizeof(extra), "entradas=%zu", ev.qtdEntradas);
+    registrar("mestre", "montarEvidencias", "aleatoria", n, t1 - t0, aloc1 - aloc0, n, rssAtualKB(), ok, extra);
+    snprintf(extra, sizeof(extra), "suspeitos=%zu ms=%.3f", pontuados, (t2 - t1) / 1e6);
+    registrar("mestre", "pontuarSuspeitos", "aleatoria", n, t2 - t1, benchAlocacoes - aloc1, n, rssAtualKB(),
+              ok, extra);
+
+    liberarPontuacao(&pt);
+    liberarInvestigacao(&inv);
+    liberarEvidencias(&ev);
+    liberarHash(&ht);
+    liberarPool(&ps);
+    free(suspeitos);
+    free(chaves);
+}
+
+/* listas de suspeitos: cada pista de montarCaso ganha de 0 a 7 suspeitos além
+   do principal, sorteados numa janela de 16 ids a partir dele (pistas vizinhas
+   compartilham suspeitos); consultas de 3 pistas do mesmo bloco de 16.
+   ok se as primeiras 1000 interseções batem com a busca ingênua */
+static void benchListasSuspeitos(size_t n) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, DIST_ALEATORIA);
+    PoolStrings ps;
+    HashTable ht;
+    montarCaso(n, &ps, &ht, chaves);
+    size_t qtdSuspeitos = (n + 3) / 4;
+    StrId *suspeitos = malloc(qtdSuspeitos * sizeof *suspeitos);
+    StrId *pistas = malloc(n * sizeof *pistas);
+    if (!suspeitos || !pistas) { fprintf(stderr, "Erro: memória para listas\n"); exit(EXIT_FAILURE); }
+    char nome[CHAVE_LEN];
+    for (size_t k = 0; k < qtdSuspeitos; ++k) {
+        snprintf(nome, CHAVE_LEN, "Suspeito %zu", k);
+        suspeitos[k] = buscarString(&ps, nome);
+    }
+    for (size_t i = 0; i < n; ++i) pistas[i] = buscarString(&ps, chaves[i]);
+
+    uint64_t estado = 0x9E3779B97F4A7C15ULL;
+    size_t pares = n, aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    for (size_t i = 0; i < n; ++i) {
+        unsigned extras = (unsigned) (proximoAleatorio(&estado) % 8);
+        for (unsigned k = 0; k < extras; ++k) {
+            size_t id = (i / 4 + proximoAleatorio(&estado) % 16) % qtdSuspeitos;
+            acrescentarSuspeitoStr(&ht, pistas[i], suspeitos[id]);
+            pares++;
+        }
+    }
+    double t1 = agoraNs();
+    size_t aloc1 = benchAlocacoes;
+    size_t postagens = ht.qtd + ht.qtdExtras;
+    char extra[64];
+    snprintf(extra, sizeof(extra), "bytes/assoc=%.2f (int: 4)",
+             postagens ? (double) (ht.usadoListas - ht.lixoListas) / (double) postagens : 0.0);
+    registrar("mestre", "acrescentarSuspeito", "aleatoria", pares - n, t1 - t0, aloc1 - aloc0, pares - n,
+              rssAtualKB(), postagens <= pares, extra);
+
+    size_t consultas = n < 100000 ? n : 100000, usadas, achados = 0;
+    int *saida = malloc(qtdSuspeitos * sizeof(int));
+    int *a = malloc(16 * sizeof(int)), *b = malloc(16 * sizeof(int)), *c = malloc(16 * sizeof(int));
+    if (!saida || !a || !b || !c) { fprintf(stderr, "Erro: memória para listas\n"); exit(EXIT_FAILURE); }
+    int ok = 1;
+    aloc1 = benchAlocacoes;
+    double t2 = agoraNs(), tConferir = 0.0;
+    for (size_t q = 0; q < consultas; ++q) {
+        size_t bloco = (proximoAleatorio(&estado) % n) & ~(size_t) 15;
+        StrId consulta[3];
+        for (int k = 0; k < 3; ++k) {
+            size_t i = bloco + proximoAleatorio(&estado) % 16;
+            consulta[k] = pistas[i < n ? i : n - 1];
+        }
+        size_t qtd = intersectarSuspeitos(&ht, consulta, 3, saida, &usadas);
+        achados += qtd;
+        if (q < 1000) {
+            double t = agoraNs();
+            size_t na = suspeitosDaPista(&ht, consulta[0], a, 16), nb = suspeitosDaPista(&ht, consulta[1], b, 16);
+            size_t nc = suspeitosDaPista(&ht, consulta[2], c, 16), esperados = 0;
+            for (size_t x = 0; x < na; ++x) {
+                int emB = 0, emC = 0;
+                for (size_t y = 0; y < nb; ++y) emB |= b[y] == a[x];
+                for (size_t y = 0; y < nc; ++y) emC |= c[y] == a[x];
+                if (emB && emC) ok &= esperados < qtd && saida[esperados++] == a[x];
+            }
+            ok &= esperados == qtd && usadas == 3;
+            tConferir += agoraNs() - t;
+        }
+    }
+    double t3 = agoraNs();
+    snprintf(extra, sizeof(extra), "3 pistas, media=%.2f candidatos", (double) achados / (double) consultas);
+    registrar("mestre", "intersectarSuspeitos", "aleatoria", consultas, t3 - t2 - tConferir,
+              benchAlocacoes - aloc1, consultas, rssAtualKB(), ok, extra);
+
+    free(a);
+    free(b);
+    free(c);
+    free(saida);
+    liberarHash(&ht);
+    liberarPool(&ps);
+    free(pistas);
+    free(suspeitos);
+    free(chaves);
+}
+
+/* emOrdem: nós da BST em ordem (pilha explícita); devolve quantos */
+static size_t emOrdem(const BSTNode *raiz, const BSTNode **saida) {
+    const BSTNode *pilha[BST_ALTURA_MAX];
+    int topo = 0;
+    size_t k = 0;
+    for (const BSTNode *x = raiz; x || topo > 0; x = x->dir) {
+        for (; x; x = x->esq) pilha[topo++] = x;
+        x = pilha[--topo];
+        saida[k++] = x;
+    }
+    return k;
+}
+
+/* mesmaInvestigacao: mesmas pistas (texto, coletas, suspeito) e contagens */
+static int mesmaInvestigacao(const Investigacao *a, const Investigacao *b, const BSTNode **va,
+                             const BSTNode **vb, size_t qtdSuspeitos) {
+    size_t na = emOrdem(a->raizPistas, va), nb = emOrdem(b->raizPistas, vb);
+    int ok = na == nb && na == a->pistasDistintas && nb == b->pistasDistintas && a->qtdRanking == b->qtdRanking;
+    for (size_t k = 0; ok && k < na; ++k)
+        ok = va[k]->pista == vb[k]->pista && va[k]->contador == vb[k]->contador && va[k]->suspeito == vb[k]->suspeito;
+    for (size_t k = 0; ok && k < qtdSuspeitos; ++k)
+        ok = a->pistasPorSuspeito[k] == b->pistasPorSuspeito[k];
+    for (size_t k = 0; ok && k < b->qtdRanking; ++k)
+        ok = k == 0 || b->pistasPorSuspeito[b->ranking[k - 1]] >= b->pistasPorSuspeito[b->ranking[k]];
+    return ok;
+}
+
+/* coletarPistasEmLote contra coletarPista uma a uma: n entradas, 1/8 delas
+   repetindo uma pista anterior */
+static void benchLote(size_t n, Distribuicao d) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, d);
+    PoolStrings ps;
+    HashTable ht;
+    montarCaso(n, &ps, &ht, chaves);
+    PistaLote *lote = malloc(n * sizeof *lote);
+    const BSTNode **va = malloc(n * sizeof *va), **vb = malloc(n * sizeof *vb);
+    if (!lote || !va || !vb) { fprintf(stderr, "Erro: memória para o lote\n"); exit(EXIT_FAILURE); }
+    for (size_t i = 0; i < n; ++i) {
+        lote[i].pista = buscarString(&ps, chaves[(i & 7) == 7 ? i / 2 : i]);
+        lote[i].contador = 1;
+    }
+    size_t qtdSuspeitos = ht.suspeitos.qtd;
+
+    Investigacao uma, lote1, lote4;
+    inicializarInvestigacao(&uma);
+    inicializarInvestigacao(&lote1);
+    inicializarInvestigacao(&lote4);
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    for (size_t i = 0; i < n; ++i) coletarPista(&uma, &ht, lote[i].pista);
+    double t1 = agoraNs();
+    size_t aloc1 = benchAlocacoes;
+    coletarPistasEmLote(&lote1, &ht, lote, n, 1);
+    double t2 = agoraNs();
+    size_t aloc2 = benchAlocacoes;
+    coletarPistasEmLote(&lote4, &ht, lote, n / 2, 4);
+    coletarPistasEmLote(&lote4, &ht, lote + n / 2, n - n / 2, 4);
+    double t3 = agoraNs();
+
+    int bits = 0;
+    for (size_t k = lote1.pistasDistintas; k; k >>= 1) bits++;
+    int ok1 = mesmaInvestigacao(&uma, &lote1, va, vb, qtdSuspeitos) && lote1.raizPistas->altura == bits;
+    int ok4 = mesmaInvestigacao(&uma, &lote4, va, vb, qtdSuspeitos);
+    char extra[48];
+    snprintf(extra, sizeof(extra), "altura=%d", uma.raizPistas->altura);
+    registrar("mestre", "coletarPista(uma a uma)", nomesDist[d], n, t1 - t0, aloc1 - aloc0, n, rssAtualKB(), 1, extra);
+    snprintf(extra, sizeof(extra), "altura=%d", lote1.raizPistas->altura);
+    registrar("mestre", "coletarPistasEmLote(1)", nomesDist[d], n, t2 - t1, aloc2 - aloc1, n, rssAtualKB(), ok1, extra);
+    snprintf(extra, sizeof(extra), "2 metades, altura=%d", lote4.raizPistas->altura);
+    registrar("mestre", "coletarPistasEmLote(4)", nomesDist[d], n, t3 - t2, benchAlocacoes - aloc2, n,
+              rssAtualKB(), ok4, extra);
+
+    liberarInvestigacao(&uma);
+    liberarInvestigacao(&lote1);
+    liberarInvestigacao(&lote4);
+    liberarHash(&ht);
+    liberarPool(&ps);
+    free(va);
+    free(vb);
+    free(lote);
+    free(chaves);
+}
+
+/* salvarSessao / carregarSessao com n pistas coletadas (mapa de uma sala no
+   mesmo pool); a carga é comparada com o estado gravado */
+static void benchSessao(size_t n) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, DIST_ALEATORIA);
+    PoolStrings ps;
+    HashTable ht;
+    montarCaso(n, &ps, &ht, chaves);
+    Mansao m;
+    inicializarMansao(&m, &ps);
+    criarSala(&m, "Hall de Entrada", chaves[0]);
+    indexarMansao(&m);
+    Navegacao nav;
+    iniciarNavegacao(&nav, &m);
+    Investigacao inv;
+    inicializarInvestigacao(&inv);
+    for (size_t i = 0; i < n; ++i) coletarPista(&inv, &ht, buscarString(&ps, chaves[i]));
+    int maisCitado = inv.maisCitado;
+    size_t qtdRanking = inv.qtdRanking;
+
+    char modelo[] = "/tmp/dq_bench_sessaoXXXXXX";
+    int fd = mkstemp(modelo);
+    if (fd < 0) { perror("mkstemp"); exit(EXIT_FAILURE); }
+    close(fd);
+
+    size_t aloc0 = benchAlocacoes;
+    double t0 = agoraNs();
+    int ok = salvarSessao(modelo, &m, &ht, &inv, &nav) == 0;
+    double t1 = agoraNs();
+    size_t aloc1 = benchAlocacoes;
+    struct stat st;
+    long tamKB = stat(modelo, &st) == 0 ? (long) (st.st_size / 1024) : -1;
+    char extra[48];
+    snprintf(extra, sizeof(extra), "arquivo=%ldKiB", tamKB);
+    registrar("mestre", "salvarSessao", "aleatoria", n, t1 - t0, aloc1 - aloc0, n, rssAtualKB(), ok, extra);
+
+    liberarInvestigacao(&inv);
+    inicializarInvestigacao(&inv);
+    aloc1 = benchAlocacoes;
+    double t2 = agoraNs();
+    ok = carregarSessao(modelo, &m, &ht, &inv, &nav) == 0;
+    double t3 = agoraNs();
+    int bitsN = 0;
+    for (size_t k = n; k; k >>= 1) bitsN++;
+    ok = ok && inv.pistasDistintas == n && inv.maisCitado == maisCitado && inv.qtdRanking == qtdRanking &&
+         inv.raizPistas->altura == bitsN && /* montada balanceada, não reinserida */
+         contadorPistasParaSuspeito(&inv, &ht, "Suspeito 0") == 4 &&
+         buscarPistaNode(&ps, inv.raizPistas, chaves[n / 2]) != NULL;
+    snprintf(extra, sizeof(extra), "ms=%.3f", (t3 - t2) / 1e6);
+    registrar("mestre", "carregarSessao", "aleatoria", n, t3 - t2, benchAlocacoes - aloc1, n, rssAtualKB(),
+              ok, extra);
+
+    remove(modelo);
+    liberarInvestigacao(&inv);
+    liberarNavegacao(&nav);
+    liberarHash(&ht);
+    liberarMansao(&m);
+    liberarPool(&ps);
+    free(chaves);
+}
+
+/* -------------------- Percursos: iterativos x recursivos -------------------- */
+
+/* referência: inserção AVL recursiva, como era antes da versão iterativa */
+static BSTNode* inserirPistaRecursiva(Arena *arena, const PoolStrings *ps, BSTNode *raiz, StrId pista, int suspeito) {
+    if (raiz == NULL) {
+        BSTNode *n = (BSTNode*) arenaAlocar(arena, sizeof(BSTNode));
+        n->pista = pista;
+        n->contador = 1;
+        n->altura = 1;
+        n->suspeito = suspeito;
+        n->esq = n->dir = NULL;
+        return n;
+    }
+    int cmp = (pista == raiz->pista) ? 0 : strcmp(texto(ps, pista), texto(ps, raiz->pista));
+    if (cmp == 0) {
+        raiz->contador += 1;
+        return raiz;
+    } else if (cmp < 0) {
+        raiz->esq = inserirPistaRecursiva(arena, ps, raiz->esq, pista, suspeito);
+    } else {
+        raiz->dir = inserirPistaRecursiva(arena, ps, raiz->dir, pista, suspeito);
+    }
+    return balancear(raiz);
+}
+
+/* referência: in-order recursivo do relatório */
+static void imprimirPistasRecursivo(const BSTNode *raiz, HashTable *ht, Saida *out) {
+    if (!raiz) return;
+    imprimirPistasRecursivo(raiz->esq, ht, out);
+    const char *sus = nomeSuspeito(ht, raiz->suspeito);
+    saidaPrintf(out, " - \"%s\" (coletada %d vez(es)) => aponta para: %s\n",
+                texto(ht->strings, raiz->pista), raiz->contador, sus ? sus : "(nenhum)");
+    imprimirPistasRecursivo(raiz->dir, ht, out);
+}
+
+/* referência: liberação pós-ordem recursiva do Novato */
+static void liberarArvoreRecursiva(SalaNovato *raiz) {
+    if (raiz == NULL) return;
+    liberarArvoreRecursiva(raiz->esquerda);
+    liberarArvoreRecursiva(raiz->direita);
+    free(raiz);
+}
+
+/* inserção e in-order, iterativos x recursivos, na mesma sequência de chaves */
+static void benchPercursosBST(size_t n, Distribuicao d) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, d);
+    PoolStrings ps;
+    inicializarPool(&ps);
+    HashTable ht;
+    inicializarHash(&ht, &ps);
+    StrId *ids = malloc(n * sizeof *ids);
+    if (!ids) { fprintf(stderr, "Erro: memória para ids\n"); exit(EXIT_FAILURE); }
+    for (size_t i = 0; i < n; ++i) ids[i] = internarString(&ps, chaves[i]);
+    Saida mudo;
+    inicializarSaida(&mudo, stdout, SAIDA_SILENCIOSA);
+
+    for (int recursiva = 1; recursiva >= 0; --recursiva) {
+        Arena arena;
+        inicializarArena(&arena);
+        BSTNode *raiz = NULL;
+        double t0 = agoraNs();
+        for (size_t i = 0; i < n; ++i)
+            raiz = recursiva ? inserirPistaRecursiva(&arena, &ps, raiz, ids[i], -1)
+                             : inserirPista(&arena, &ps, raiz, ids[i], -1, NULL);
+        double t1 = agoraNs();
+        if (recursiva) imprimirPistasRecursivo(raiz, &ht, &mudo);
+        else imprimirPistasComContagem(raiz, &ht, &mudo);
+        double t2 = agoraNs();
+
+        char extra[48];
+        snprintf(extra, sizeof(extra), "altura=%d", alturaNo(raiz));
+        registrar("mestre", recursiva ? "inserirPista(recursiva)" : "inserirPista(iterativa)", nomesDist[d],
+                  n, t1 - t0, 0, n, rssAtualKB(), 1, extra);
+        registrar("mestre", recursiva ? "inorder(recursivo)" : "inorder(iterativo)", nomesDist[d],
+                  n, t2 - t1, 0, n, rssAtualKB(), 1, extra);
+        liberarArena(&arena);
+    }
+
+    liberarSaida(&mudo);
+    liberarHash(&ht);
+    liberarPool(&ps);
+    free(ids);
+    free(chaves);
+}
+
+/* liberarArvore do Novato: completa (iterativa x recursiva) e cadeia degenerada */
+static void benchLiberarArvore(size_t n) {
+    for (int forma = 0; forma < 3; ++forma) {
+        SalaNovato **nos = malloc(n * sizeof *nos);
+        if (!nos) { fprintf(stderr, "Erro: memória para nós\n"); exit(EXIT_FAILURE); }
+        for (size_t i = 0; i < n; ++i) {
+            nos[i] = criarSalaNovato("Sala");
+            if (i == 0) continue;
+            if (forma == 2) nos[i - 1]->esquerda = nos[i]; /* cadeia: profundidade n */
+            else if (i & 1) nos[(i - 1) / 2]->esquerda = nos[i];
+            else nos[(i - 1) / 2]->direita = nos[i];
+        }
+        SalaNovato *raiz = nos[0];
+        free(nos);
+        double t0 = agoraNs();
+        if (forma == 1) liberarArvoreRecursiva(raiz);
+        else liberarArvoreNovato(raiz);
+        double t1 = agoraNs();
+        registrar("novato", forma == 1 ? "liberarArvore(recursiva)" : "liberarArvore(iterativa)",
+                  forma == 2 ? "degenerada" : "completa", n, t1 - t0, 0, n, rssAtualKB(), 1, "");
+    }
+}
+
+/* chamadas write(2) feitas pelo processo até agora (Linux); 0 se indisponível */
+static unsigned long long escritasProcesso(void) {
+    FILE *f = fopen("/proc/self/io", "r");
+    if (!f) return 0;
+    char linha[128];
+    unsigned long long v = 0;
+    while (fgets(linha, sizeof(linha), f))
+        if (sscanf(linha, "syscw: %llu", &v) == 1) break;
+    fclose(f);
+    return v;
+}
+
+/* relatório de n pistas (lista in-order + suspeitos) em cada modo de saída;
+   o destino tem buffer de linha, como stdout ligado a um terminal */
+static void benchSaida(size_t n) {
+    char (*chaves)[CHAVE_LEN] = gerarChaves(n, DIST_ALEATORIA);
+    PoolStrings ps;
+    HashTable ht;
+    montarCaso(n, &ps, &ht, chaves);
+    Investigacao inv;
+    inicializarInvestigacao(&inv);
+    for (size_t i = 0; i < n; ++i) coletarPista(&inv, &ht, buscarString(&ps, chaves[i]));
+
+    static const char *nomes[] = { "relatorio(buffer)", "relatorio(direta)", "relatorio(silenciosa)" };
+    const ModoSaida modos[] = { SAIDA_BUFFER, SAIDA_DIRETA, SAIDA_SILENCIOSA };
+    for (int k = 0; k < 3; ++k) {
+        FILE *destino = fopen("/dev/null", "w");
+        if (!destino) { perror("/dev/null"); exit(EXIT_FAILURE); }
+        setvbuf(destino, NULL, _IOLBF, BUFSIZ);
+        Saida out;
+        inicializarSaida(&out, destino, modos[k]);
+
+        unsigned long long w0 = escritasProcesso();
+        size_t aloc0 = benchAlocacoes;
+        double t0 = agoraNs();
+        imprimirPistasComContagem(inv.raizPistas, &ht, &out);
+        imprimirSuspeitos(&ht, &out);
+        saidaDescarregar(&out);
+        double t1 = agoraNs();
+        size_t aloc = benchAlocacoes - aloc0;
+        unsigned long long escritas = escritasProcesso() - w0;
+        long rss = rssAtualKB();
+
+        char extra[48];
+        snprintf(extra, sizeof(extra), "write=%llu", escritas);
+        registrar("mestre", nomes[k], "aleatoria", n, t1 - t0, aloc, n, rss, 1, extra);
+        liberarSaida(&out);
+        fclose(destino);
+    }
+
+    liberarInvestigacao(&inv);
+    liberarHash(&ht);
+    liberarPool(&ps);
+    free(chaves);
+}
+
+/* -------------------- Comparação com uma execução anterior -------------------- */
+
+/* lê a base --csv e compara ns/op das medidas de mesma chave; retorna nº de regressões */
+static int compararComBase(const char *caminho) {
+    FILE *f = fopen(caminho, "r");
+    if (!f) { perror(caminho); return -1; }
+    char linha[512];
+    int regressoes = 0;
+    size_t comparadas = 0;
+    fprintf(stderr, "\n%-12s %-26s %-10s %10s %12s %12s %8s\n", "nivel", "operacao", "dist", "n",
+            "base ns/op", "atual ns/op", "razao");
+    while (fgets(linha, sizeof(linha), f)) {
+        char nivel[32], operacao[64], dist[32];
+        size_t n;
+        double ns;
+        if (sscanf(linha, "%31[^,],%63[^,],%31[^,],%zu,%lf", nivel, operacao, dist, &n, &ns) != 5) continue;
+        for (size_t i = 0; i < qtdMedidas; ++i) {
+            const Medida *m = &medidas[i];
+            if (m->n != n || strcmp(m->nivel, nivel) || strcmp(m->operacao, operacao) ||
+                strcmp(m->distribuicao, dist)) continue;
+            double razao = ns > 0 ? m->nsOp / ns : 1.0;
+            int pior = razao > LIMITE_REGRESSAO;
+            regressoes += pior;
+            comparadas++;
+            fprintf(stderr, "%-12s %-26s %-10s %10zu %12.1f %12.1f %7.2fx%s\n", nivel, operacao, dist, n,
+                    ns, m->nsOp, razao, pior ? "  REGRESSAO" : "");
+            break;
+        }
+    }
+    fclose(f);
+    fprintf(stderr, "%zu medidas comparadas, %d regressão(ões) acima de %.0f%%\n",
+            comparadas, regressoes, (LIMITE_REGRESSAO - 1) * 100);
+    return regressoes;
+}
+
+int main(int argc, char **argv) {
+    int expMax = 6;
+    const char *base = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--csv") == 0) saidaCSV = 1;
+        else if (strcmp(argv[i], "--comparar") == 0 && i + 1 < argc) base = argv[++i];
+        else expMax = atoi(argv[i]);
+    }
+    if (expMax < 3) expMax = 3;
+
+    if (saidaCSV) {
+        printf("nivel,operacao,distribuicao,n,ns_op,aloc_op,rss_kb,ok,extra\n");
+    } else {
+        printf("bytes por nó: Sala(novato) %zu, Sala(mestre) %zu, BSTNode %zu, HashEntry %zu\n\n",
+               sizeof(SalaNovato), sizeof(Sala), sizeof(BSTNode), sizeof(HashEntry));
+        printf("%-12s %-26s %-10s %10s %12s %10s %10s %-5s %s\n", "nivel", "operacao", "dist", "n",
+               "ns/op", "aloc/op", "rss_kb", "ok", "extra");
+    }
+
+    const size_t capacidades[] = { 16, HASH_SIZE, 4096 };
+    size_t n = 1000;
+    for (int e = 3; e <= expMax; ++e, n *= 10) {
+        benchCriarSalaNovato(n, "novato");
+        benchCriarSalaAventureiro(n, "aventureiro");
+        benchMansao(n);
+        benchGerador(n, FORMA_BALANCEADA, "balanceada");
+        benchGerador(n, FORMA_ALEATORIA, "aleatoria");
+        benchRotas(n);
+        for (int d = DIST_ORDENADA; d <= DIST_PREFIXO; ++d) benchIndicePistas(n, (Distribuicao) d);
+        for (size_t c = 0; c < sizeof(capacidades) / sizeof(capacidades[0]); ++c) {
+            benchHash(n, capacidades[c], DIST_ALEATORIA);
+            benchHash(n, capacidades[c], DIST_PREFIXO);
+        }
+        benchHash(n, n, DIST_ALEATORIA); /* já dimensionada: sem redimensionamento */
+        benchHashTexto(n);
+        benchSuspeitosUnicos(n);
+        benchContagemSuspeitos(n);
+        benchVeredito(n);
+        benchEvidencias(n);
+        benchListasSuspeitos(n);
+        benchSessao(n);
+        benchLote(n, DIST_ORDENADA);
+        benchLote(n, DIST_ALEATORIA);
+        benchSaida(n);
+        benchPercursosBST(n, DIST_ORDENADA);
+        benchPercursosBST(n, DIST_ALEATORIA);
+        benchLiberarArvore(n);
+        benchBuscaTexto(n);
+    }
+
+    if (base) return compararComBase(base) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
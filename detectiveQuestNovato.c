@@ -55,7 +55,11 @@ void explorarSalas(Sala* atual) {
         printf(" - (s) Sair da exploração\n");
 
         printf("Opção: ");
-        scanf(" %c", &escolha);
+        if (scanf(" %c", &escolha) != 1) {
+            // Fim da entrada (ex.: arquivo redirecionado): encerra em vez de repetir o menu
+            printf("\nFim da entrada. Exploração encerrada.\n");
+            return;
+        }
 
         if (escolha == 'e' || escolha == 'E') {
             if (atual->esquerda != NULL)
@@ -76,24 +80,74 @@ void explorarSalas(Sala* atual) {
     }
 }
 
+/*
+ * Função: executarLote
+ * ---------------------
+ * Modo não interativo: cada linha do arquivo é uma sessão de comandos
+ * (e, d, s; espaços ignorados) sempre a partir do Hall, sem menus.
+ * Para cada sessão imprime uma linha "sessao;passos;invalidos;sala_final".
+ */
+void executarLote(Sala* hall, FILE* entrada) {
+    int sessao = 0;
+    int c;
+
+    printf("sessao;passos;invalidos;sala_final\n");
+    /* lida caractere a caractere: uma linha é sempre uma sessão, de qualquer tamanho */
+    while ((c = getc(entrada)) != EOF) {
+        Sala* atual = hall;
+        int passos = 0, invalidos = 0, encerrada = 0;
+
+        for (; c != EOF && c != '\n'; c = getc(entrada)) {
+            if (encerrada || c == ' ' || c == '\t' || c == '\r') continue;
+            if (c == 's' || c == 'S') { encerrada = 1; continue; } /* resto da linha ignorado */
+
+            Sala* proxima = NULL;
+            if (c == 'e' || c == 'E') proxima = atual->esquerda;
+            else if (c == 'd' || c == 'D') proxima = atual->direita;
+
+            if (proxima != NULL) {
+                atual = proxima;
+                passos++;
+            } else {
+                invalidos++;
+            }
+        }
+        printf("%d;%d;%d;%s\n", ++sessao, passos, invalidos, atual->nome);
+    }
+}
+
 /*
  * Função: liberarArvore
  * ----------------------
  * Libera toda a memória alocada para a árvore de salas.
+ * Iterativa e sem pilha: enquanto houver filho à esquerda, faz uma rotação
+ * à direita (o filho sobe); sem filho à esquerda, libera a sala e segue
+ * pela direita. Funciona mesmo em árvores degeneradas muito profundas.
  */
 void liberarArvore(Sala* raiz) {
-    if (raiz == NULL) return;
-    liberarArvore(raiz->esquerda);
-    liberarArvore(raiz->direita);
-    free(raiz);
+    while (raiz != NULL) {
+        if (raiz->esquerda != NULL) {
+            Sala* filho = raiz->esquerda;
+            raiz->esquerda = filho->direita;
+            filho->direita = raiz;
+            raiz = filho;
+        } else {
+            Sala* proxima = raiz->direita;
+            free(raiz);
+            raiz = proxima;
+        }
+    }
 }
 
+// DQ_SEM_MAIN permite incluir este arquivo em programas auxiliares (ex.: benchmarks)
+#ifndef DQ_SEM_MAIN
 /*
  * Função principal
  * -----------------
  * Monta a estrutura fixa da mansão e inicia a exploração.
+ * Com "--lote arquivo" (ou "--lote -" para stdin) executa as sessões em lote.
  */
-int main() {
+int main(int argc, char* argv[]) {
     setlocale(LC_ALL, "Portuguese");
 
     // Montagem manual da árvore de salas (mapa da mansão)
@@ -113,6 +167,20 @@ int main() {
     cozinha->direita = escritorio;
     escritorio->direita = porao;
 
+    // Modo em lote: sem menus, apenas um registro por sessão
+    if (argc == 3 && strcmp(argv[1], "--lote") == 0) {
+        FILE* entrada = strcmp(argv[2], "-") == 0 ? stdin : fopen(argv[2], "r");
+        if (entrada == NULL) {
+            printf("Erro ao abrir o arquivo de sessões: %s\n", argv[2]);
+            liberarArvore(hall);
+            return 1;
+        }
+        executarLote(hall, entrada);
+        if (entrada != stdin) fclose(entrada);
+        liberarArvore(hall);
+        return 0;
+    }
+
     printf("=== Detective Quest: A Mansão Misteriosa ===\n");
     printf("Explore os cômodos e descubra os segredos escondidos...\n");
 
@@ -124,3 +192,4 @@ int main() {
 
     return 0;
 }
+#endif